@@ -6,6 +6,9 @@
 #include "color.hpp"
 #include "globals.hpp"
 #include "time.hpp"
+#include "loader.hpp"
+#include "render/tiled.hpp"
+#include "render/document.hpp"
 
 namespace plgl {
 
@@ -65,6 +68,51 @@ namespace plgl {
 		renderer->clip(x1, y1, x2, y2);
 	}
 
+	/**
+	 * @brief Push nested clip rectangle.
+	 *
+	 * The new clip area is the intersection of the given rectangle and
+	 * the currently active one, use clip_pop() to restore the previous clip area.
+	 *
+	 * @see plgl::clip_pop()
+	 */
+	inline void clip_push(float x1, float y1, float x2, float y2) {
+		renderer->clip_push(x1, y1, x2, y2);
+	}
+
+	/// Restore the clip area that was active before the last clip_push()
+	inline void clip_pop() {
+		renderer->clip_pop();
+	}
+
+	/**
+	 * @brief Select clipping method.
+	 *
+	 * By default (CLIP_GEOMETRY) clipped geometry is cut on the CPU, which
+	 * allows changing the clip area without breaking draw batches. CLIP_SCISSOR uses the
+	 * GPU scissor test instead, which should be preferred with polygon(LINES) as it
+	 * doesn't introduce any additional edges.
+	 */
+	inline void clip_mode(ClipMode mode) {
+		renderer->clip_mode(mode);
+	}
+
+	/**
+	 * @brief Reorder opaque geometry.
+	 *
+	 * When enabled every triangle is assigned a depth value matching its submission order,
+	 * this allows fully opaque shapes and images to be grouped by texture and drawn in far fewer draw calls,
+	 * while translucent geometry (including all text) still renders in order. The output is the same
+	 * as without depth sorting, but scenes that often switch between textures (like tile maps) render much faster.
+	 *
+	 * @note Requires a framebuffer with a 24 bit depth buffer.
+	 *
+	 * @param[in] enable Whether depth sorting should be used
+	 */
+	inline void depth_sort(bool enable) {
+		renderer->depth_sort(enable);
+	}
+
 	inline void texture(Sprite& sprite) {
 		renderer->texture(sprite);
 	}
@@ -81,10 +129,92 @@ namespace plgl {
 		renderer->font(f);
 	}
 
+	/**
+	 * @brief Use custom effect.
+	 *
+	 * All shapes and images drawn after this call will be shaded using the
+	 * given effect, until shader(OFF) is called. Text is not affected.
+	 *
+	 * @see plgl::Effect
+	 */
+	inline void shader(Effect& effect) {
+		renderer->shader(effect);
+	}
+
+	inline void shader(Disabled disabled) {
+		renderer->shader(disabled);
+	}
+
+	/**
+	 * @brief Add post-processing filter.
+	 *
+	 * Filters are applied, in the order they were added, to the whole frame when
+	 * swap() is called. Each filter reads the output of the previous one, expensive filters (like blurs)
+	 * can be run at a lower resolution by passing a scale below 1. Filters stay active
+	 * until filter(OFF) is called, a newly added filter takes effect from the next frame.
+	 *
+	 * @example
+	 * @code{.cpp}
+	 * Effect invert {R"(
+	 *     vec4 shade(vec4 color, vec2 uv) {
+	 *         return vec4(1.0 - texel(uv).rgb, 1.0);
+	 *     }
+	 * )"};
+	 *
+	 * filter(invert);
+	 * @endcode
+	 *
+	 * @param[in] effect The effect to apply
+	 * @param[in] scale  Resolution of this pass relative to the window
+	 */
+	inline void filter(Effect& effect, float scale = 1.0f) {
+		renderer->filter(effect, scale);
+	}
+
+	inline void filter(Disabled disabled) {
+		renderer->filter(disabled);
+	}
+
 	inline void size(float s) {
 		renderer->size(s);
 	}
 
+	/// Set how lines of text are aligned, relative to the wrap width or the widest line
+	inline void text_align(TextAlign align) {
+		renderer->text_align(align);
+	}
+
+	/// Break text at spaces so that lines are no wider than the given width, zero disables wrapping
+	inline void text_wrap(float width) {
+		renderer->text_wrap(width);
+	}
+
+	/// Set the distance between lines of text, as a multiple of the text size
+	inline void text_spacing(float spacing) {
+		renderer->text_spacing(spacing);
+	}
+
+	/**
+	 * @brief Measure text width.
+	 *
+	 * Returns the advance of the widest line of the text, as it would be drawn
+	 * with the current font, size, and text settings. The layout is cached, so measuring text and then
+	 * drawing it costs no more than just drawing it.
+	 */
+	inline float text_width(const std::string& str) {
+		return renderer->text_layout(str).width();
+	}
+
+	/// Measure the distance from the top of the first line to the baseline of the last one
+	inline float text_height(const std::string& str) {
+		return renderer->text_layout(str).height();
+	}
+
+	/// Get the box containing all glyphs of the text, relative to the position it would be drawn at
+	inline TextBounds text_bounds(const std::string& str) {
+		return renderer->text_layout(str).bounds();
+	}
+
 	inline void arc(float x, float y, float hrad, float vrad, float start, float angle, ArcMode mode = OPEN_PIE) {
 		renderer->arc(x, y, hrad, vrad, angle, start, mode);
 	}
@@ -149,10 +279,40 @@ namespace plgl {
 		renderer->image(x, y);
 	}
 
+	/**
+	 * @brief Draw tiled image.
+	 *
+	 * Draws the visible part of a TiledImage into the given rectangle, the
+	 * tiles are drawn using the current tint and the tile texture is left selected as the current texture.
+	 */
+	inline void image(TiledImage& image, float x, float y, float w, float h) {
+		image.draw(x, y, w, h);
+	}
+
 	inline void text(float x, float y, const std::string& str) {
 		renderer->text(x, y, str);
 	}
 
+	/**
+	 * @brief Draw prepared text.
+	 *
+	 * Draws a TextLayout with its own font and size, the glyphs were already positioned
+	 * when the layout was built so this only copies them to the given position.
+	 */
+	inline void text(float x, float y, TextLayout& layout) {
+		renderer->text(x, y, layout);
+	}
+
+	/**
+	 * @brief Draw large text.
+	 *
+	 * Draws the lines of a TextDocument that are visible in the box with its top left
+	 * corner at (x, y), at the document scroll position. Lines outside the box are never decoded.
+	 */
+	inline void text(TextDocument& document, float x, float y, float w, float h) {
+		document.draw(x, y, w, h);
+	}
+
 	template<class... Args>
 	void textf(float x, float y, const std::string& str, Args&&... args) {
 		renderer->textf(x, y, str, args...);
@@ -202,4 +362,72 @@ namespace plgl {
 		SoundSystem::get()->tone(waveform, volume, frequency, milliseconds);
 	}
 
+	/*
+	 * Loading
+	 */
+
+	/**
+	 * @brief Load texture in the background.
+	 *
+	 * The image is decoded on a worker thread, the returned texture can be used
+	 * right away but stays transparent until it is loaded. Loaded assets are finished during swap(),
+	 * spending at most a few milliseconds per frame (see load_budget()).
+	 *
+	 * @example
+	 * @code{.cpp}
+	 * Texture& cat = load_texture("assets/cat.png");
+	 *
+	 * while (!should_close) {
+	 *     if (!load_ready()) {
+	 *         text(10, 20, "Loading " + std::to_string((int) (load_progress() * 100)) + "%");
+	 *     }
+	 *
+	 *     texture(cat);
+	 *     image(10, 30);
+	 *     swap();
+	 * }
+	 * @endcode
+	 *
+	 * @param[in] path     Path to the image file
+	 * @param[in] callback Optionally, function to invoke once the texture is ready
+	 */
+	inline Texture& load_texture(const std::string& path, const std::function<void(Texture&)>& callback = {}) {
+		return loader->texture(path, callback);
+	}
+
+	/// Load image in the background, it stays empty until it is loaded
+	inline Image& load_image(const std::string& path, const std::function<void(Image&)>& callback = {}) {
+		return loader->image(path, callback);
+	}
+
+	/// Load sound in the background, it stays silent until it is loaded
+	inline Sound& load_sound(const std::string& path, const std::function<void(Sound&)>& callback = {}) {
+		return loader->sound(path, callback);
+	}
+
+	/// Load font in the background, it draws nothing until it is loaded
+	inline Font& load_font(const std::string& path, int weight = 400, const std::function<void(Font&)>& callback = {}) {
+		return loader->font(path, weight, callback);
+	}
+
+	/// Fraction of background loads that are finished, from 0 to 1
+	inline float load_progress() {
+		return loader->progress();
+	}
+
+	/// Check if all background loads are finished
+	inline bool load_ready() {
+		return loader->ready();
+	}
+
+	/// Block until all background loads are finished
+	inline void load_wait() {
+		loader->wait();
+	}
+
+	/// Set the maximum time, per frame, spent on finishing loaded assets
+	inline void load_budget(std::chrono::microseconds budget) {
+		loader->limit(budget);
+	}
+
 };
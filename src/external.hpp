@@ -26,6 +26,8 @@
 // C++ stdlib
 #include <vector>
 #include <string>
+#include <string_view>
+#include <map>
 #include <unordered_map>
 #include <fstream>
 #include <sstream>
@@ -33,5 +35,13 @@
 #include <random>
 #include <chrono>
 #include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <deque>
 #include <list>
 #include <set>
+#include <bitset>
+#include <limits>
+#include <bit>
+#include <filesystem>
@@ -27,4 +27,5 @@ bool plgl::key_pressed = false;
 std::string plgl::last_error = "";
 plgl::Renderer* plgl::renderer = nullptr;
 plgl::SoundSystem* plgl::sound_system = nullptr;
+plgl::Loader* plgl::loader = nullptr;
 plgl::EventHandler plgl::impl::user_event_handlers[impl::EVENT_COUNT] = {};
@@ -6,6 +6,7 @@ namespace plgl {
 
 	class Renderer;
 	class SoundSystem;
+	class Loader;
 
 	extern bool opened;
 	extern bool focused;
@@ -31,6 +32,7 @@ namespace plgl {
 	extern std::string last_error;
 	extern Renderer* renderer;
 	extern SoundSystem* sound_system;
+	extern Loader* loader;
 
 	namespace impl {
 		extern EventHandler user_event_handlers[impl::EVENT_COUNT];
@@ -0,0 +1,167 @@
+
+#include "loader.hpp"
+
+namespace plgl {
+
+	/*
+	 * Loader
+	 */
+
+	void Loader::process(std::chrono::steady_clock::time_point deadline) {
+
+		while (true) {
+			Task task;
+
+			{
+				std::lock_guard lock {queue->mutex};
+
+				if (queue->finished.empty()) {
+					return;
+				}
+
+				task = std::move(queue->finished.front());
+				queue->finished.pop_front();
+			}
+
+			if (task.counted) {
+				done ++;
+			}
+
+			task.run();
+
+			if (std::chrono::steady_clock::now() >= deadline) {
+				return;
+			}
+		}
+	}
+
+	Loader::Loader()
+	: queue(std::make_shared<Queue>()) {}
+
+	Loader::~Loader() {
+		queue->cancelled = true;
+
+		for (Texture& texture : textures) {
+			texture.close();
+		}
+
+		for (Image& image : images) {
+			image.close();
+		}
+	}
+
+	Texture& Loader::texture(const std::string& path, const std::function<void(Texture&)>& callback) {
+		Texture& texture = textures.emplace_back();
+
+		// transparent placeholder, so that the texture can be drawn right away
+		const uint8_t pixel[4] = {255, 255, 255, 0};
+		texture.upload(ImageView {pixel, 1, 1, 4});
+
+		schedule<TextureFile>([path] () {
+			TextureFile file = impl::TextureCache::load(path);
+
+			// start reading now, so that the upload doesn't wait for the disk
+			file.prefetch();
+			return file;
+		}, [&texture, callback] (TextureFile& file) {
+			texture.load(file);
+
+			if (callback) callback(texture);
+		});
+
+		return texture;
+	}
+
+	Image& Loader::image(const std::string& path, const std::function<void(Image&)>& callback) {
+		Image& image = images.emplace_back();
+
+		schedule<Image>([path] () {
+			return Image::load(path);
+		}, [&image, callback] (Image& loaded) {
+			image = std::move(loaded);
+
+			if (callback) callback(image);
+		});
+
+		return image;
+	}
+
+	Sound& Loader::sound(const std::string& path, const std::function<void(Sound&)>& callback) {
+		Sound& sound = sounds.emplace_back(Sound {});
+
+		struct Samples {
+			std::shared_ptr<short> data;
+			long count;
+			int channels;
+			int rate;
+		};
+
+		schedule<Samples>([path] () {
+			int channels, rate;
+			short* data;
+
+			long count = stb_vorbis_decode_filename(path.c_str(), &channels, &rate, &data);
+
+			if (count == -1) {
+				fault("Failed to load sound: '{}'!", path);
+			}
+
+			return Samples {std::shared_ptr<short> {data, free}, count, channels, rate};
+		}, [&sound, callback] (Samples& samples) {
+			sound.upload(samples.data.get(), samples.count, samples.channels, samples.rate);
+
+			if (callback) callback(sound);
+		});
+
+		return sound;
+	}
+
+	Font& Loader::font(const std::string& path, int weight, const std::function<void(Font&)>& callback) {
+		Font& font = fonts.emplace_back(Font {});
+
+		// FreeType is not thread safe, so only the file is read in the background
+		schedule<std::vector<uint8_t>>([path] () {
+			std::ifstream file {path, std::ios::binary};
+
+			if (!file) {
+				fault("Failed to open font: '{}'", path);
+			}
+
+			return std::vector<uint8_t> (std::istreambuf_iterator<char> {file}, std::istreambuf_iterator<char> {});
+		}, [&font, path, weight, callback] (std::vector<uint8_t>& bytes) {
+			font.open(std::move(bytes), path, weight);
+
+			if (callback) callback(font);
+		});
+
+		return font;
+	}
+
+	void Loader::update() {
+		process(std::chrono::steady_clock::now() + budget);
+	}
+
+	void Loader::wait() {
+		while (done < total) {
+			{
+				std::unique_lock lock {queue->mutex};
+				queue->condition.wait(lock, [this] { return !queue->finished.empty(); });
+			}
+
+			process(std::chrono::steady_clock::time_point::max());
+		}
+	}
+
+	void Loader::limit(std::chrono::microseconds budget) {
+		this->budget = budget;
+	}
+
+	float Loader::progress() const {
+		return total == 0 ? 1.0f : done / (float) total;
+	}
+
+	bool Loader::ready() const {
+		return done == total;
+	}
+
+}
@@ -0,0 +1,134 @@
+#pragma once
+
+#include "external.hpp"
+#include "pool.hpp"
+#include "render/texture.hpp"
+#include "render/image.hpp"
+#include "render/font.hpp"
+#include "sound/sound.hpp"
+
+namespace plgl {
+
+	/**
+	 * @brief Background asset loader.
+	 *
+	 * Files are read and decoded on worker threads, while the parts that need to talk to OpenGL
+	 * or OpenAL are done on the main thread, in update(), spending no more than the configured
+	 * time budget per call. Every load method immediately returns a placeholder that becomes valid
+	 * once the asset is ready: textures are transparent, sounds are silent, fonts draw nothing and images are empty.
+	 * The loader owns all the assets it returns, they are valid until the loader is destroyed.
+	 *
+	 * @see plgl::load_texture()
+	 */
+	class Loader {
+
+		private:
+
+			// finished work waiting to be completed on the main thread
+			struct Task {
+				std::function<void()> run;
+				bool counted;
+			};
+
+			// state shared with the worker threads, outlives the loader if needed
+			struct Queue {
+				std::mutex mutex;
+				std::condition_variable condition;
+				std::deque<Task> finished;
+				std::atomic_bool cancelled = false;
+			};
+
+			std::shared_ptr<Queue> queue;
+			std::list<Texture> textures;
+			std::list<Image> images;
+			std::list<Sound> sounds;
+			std::list<Font> fonts;
+
+			size_t total = 0;
+			size_t done = 0;
+			std::chrono::microseconds budget {4000};
+
+			/// Run finished tasks until the deadline passes (or there are no more tasks)
+			void process(std::chrono::steady_clock::time_point deadline);
+
+		public:
+
+			Loader();
+			~Loader();
+
+			Loader(const Loader& other) = delete;
+			Loader& operator = (const Loader& other) = delete;
+
+			/**
+			 * Run 'work' on the thread pool and then 'finish' with its result on the main thread,
+			 * during update(), exceptions thrown by 'work' are rethrown from update() as well. Work that is not
+			 * counted (like mip levels or image tiles the library computes on its own) is not included in progress(),
+			 * ready() and wait(), which only track the assets the user asked for
+			 */
+			template <typename T>
+			void schedule(std::function<T()> work, std::function<void(T&)> finish, bool counted = true);
+
+			/// Load texture in the background, the callback is invoked once it is ready
+			Texture& texture(const std::string& path, const std::function<void(Texture&)>& callback = {});
+
+			/// Load image in the background, the callback is invoked once it is ready
+			Image& image(const std::string& path, const std::function<void(Image&)>& callback = {});
+
+			/// Load .ogg sound in the background, the callback is invoked once it is ready
+			Sound& sound(const std::string& path, const std::function<void(Sound&)>& callback = {});
+
+			/// Load font in the background, the callback is invoked once it is ready
+			Font& font(const std::string& path, int weight = 400, const std::function<void(Font&)>& callback = {});
+
+			/// Finish loaded assets on this thread, stopping once the per frame budget is exhausted
+			void update();
+
+			/// Block until all scheduled assets are ready
+			void wait();
+
+			/// Set the maximum time update() can spend finishing assets
+			void limit(std::chrono::microseconds budget);
+
+			/// Fraction of scheduled assets that are ready, 1 if there is nothing to load
+			float progress() const;
+
+			/// Check if all scheduled assets are ready
+			bool ready() const;
+
+	};
+
+	template <typename T>
+	void Loader::schedule(std::function<T()> work, std::function<void(T&)> finish, bool counted) {
+		if (counted) {
+			total ++;
+		}
+
+		impl::ThreadPool::get().submit([queue = this->queue, work = std::move(work), finish = std::move(finish), counted] () {
+			if (queue->cancelled) {
+				return;
+			}
+
+			std::function<void()> task;
+
+			try {
+				task = [value = std::make_shared<T>(work()), finish] () {
+					finish(*value);
+				};
+			} catch (...) {
+
+				// errors are reported on the main thread, during update()
+				task = [error = std::current_exception()] () {
+					std::rethrow_exception(error);
+				};
+			}
+
+			{
+				std::lock_guard lock {queue->mutex};
+				queue->finished.push_back({std::move(task), counted});
+			}
+
+			queue->condition.notify_all();
+		});
+	}
+
+}
@@ -0,0 +1,156 @@
+
+#include "mapping.hpp"
+
+#if defined(_WIN32)
+#	define WIN32_LEAN_AND_MEAN
+#	include <windows.h>
+#else
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#	include <fcntl.h>
+#	include <unistd.h>
+#endif
+
+namespace plgl::impl {
+
+	/*
+	 * MappedFile
+	 */
+
+	MappedFile::~MappedFile() {
+		close();
+	}
+
+	MappedFile::MappedFile(MappedFile&& other) noexcept {
+		*this = std::move(other);
+	}
+
+	MappedFile& MappedFile::operator = (MappedFile&& other) noexcept {
+		if (this != &other) {
+			close();
+
+			std::swap(bytes, other.bytes);
+			std::swap(length, other.length);
+
+#if defined(_WIN32)
+			std::swap(file, other.file);
+			std::swap(mapping, other.mapping);
+#endif
+		}
+
+		return *this;
+	}
+
+#if defined(_WIN32)
+
+	bool MappedFile::open(const std::string& path) {
+		close();
+
+		file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+
+		if (file == INVALID_HANDLE_VALUE) {
+			file = nullptr;
+			return false;
+		}
+
+		LARGE_INTEGER size;
+
+		if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+			close();
+			return false;
+		}
+
+		mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+		if (mapping == nullptr) {
+			close();
+			return false;
+		}
+
+		bytes = (const uint8_t*) MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		length = size.QuadPart;
+
+		if (bytes == nullptr) {
+			close();
+			return false;
+		}
+
+		return true;
+	}
+
+	void MappedFile::close() {
+		if (bytes) UnmapViewOfFile(bytes);
+		if (mapping) CloseHandle(mapping);
+		if (file) CloseHandle(file);
+
+		bytes = nullptr;
+		mapping = nullptr;
+		file = nullptr;
+		length = 0;
+	}
+
+	void MappedFile::prefetch() const {
+		if (bytes) {
+			WIN32_MEMORY_RANGE_ENTRY range {(void*) bytes, length};
+			PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+		}
+	}
+
+#else
+
+	bool MappedFile::open(const std::string& path) {
+		close();
+
+		int descriptor = ::open(path.c_str(), O_RDONLY);
+
+		if (descriptor == -1) {
+			return false;
+		}
+
+		struct stat status;
+
+		if (fstat(descriptor, &status) == -1 || status.st_size == 0) {
+			::close(descriptor);
+			return false;
+		}
+
+		void* address = mmap(nullptr, status.st_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+
+		// the mapping keeps the file alive on its own
+		::close(descriptor);
+
+		if (address == MAP_FAILED) {
+			return false;
+		}
+
+		bytes = (const uint8_t*) address;
+		length = status.st_size;
+		return true;
+	}
+
+	void MappedFile::close() {
+		if (bytes) {
+			munmap((void*) bytes, length);
+		}
+
+		bytes = nullptr;
+		length = 0;
+	}
+
+	void MappedFile::prefetch() const {
+		if (bytes) {
+			madvise((void*) bytes, length, MADV_WILLNEED);
+		}
+	}
+
+#endif
+
+	const uint8_t* MappedFile::data() const {
+		return bytes;
+	}
+
+	size_t MappedFile::size() const {
+		return length;
+	}
+
+}
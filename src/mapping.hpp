@@ -0,0 +1,51 @@
+#pragma once
+
+#include "external.hpp"
+
+namespace plgl::impl {
+
+	/**
+	 * Read-only memory mapping of a whole file, the operating system pages
+	 * the contents in on demand, so opening even a large file is cheap
+	 */
+	class MappedFile {
+
+		private:
+
+			const uint8_t* bytes = nullptr;
+			size_t length = 0;
+
+#if defined(_WIN32)
+			void* file = nullptr;
+			void* mapping = nullptr;
+#endif
+
+		public:
+
+			MappedFile() = default;
+			~MappedFile();
+
+			MappedFile(const MappedFile& other) = delete;
+			MappedFile& operator = (const MappedFile& other) = delete;
+
+			MappedFile(MappedFile&& other) noexcept;
+			MappedFile& operator = (MappedFile&& other) noexcept;
+
+			/// Map the given file, returns false (and leaves this object empty) on failure
+			bool open(const std::string& path);
+
+			/// Unmap the file, all pointers into it become invalid
+			void close();
+
+			/// Ask the operating system to start reading the whole file in the background
+			void prefetch() const;
+
+			/// returns a pointer to the start of the mapping, null if nothing is mapped
+			const uint8_t* data() const;
+
+			/// returns the size, in bytes, of the mapped file
+			size_t size() const;
+
+	};
+
+}
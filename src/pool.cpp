@@ -0,0 +1,119 @@
+
+#include "pool.hpp"
+
+namespace plgl::impl {
+
+	/*
+	 * ThreadPool
+	 */
+
+	void ThreadPool::run() {
+		while (true) {
+			std::function<void()> task;
+
+			{
+				std::unique_lock lock {mutex};
+				condition.wait(lock, [this] { return stopping || !tasks.empty(); });
+
+				// tasks left over at exit are dropped
+				if (stopping) {
+					return;
+				}
+
+				task = std::move(tasks.front());
+				tasks.pop_front();
+			}
+
+			task();
+		}
+	}
+
+	ThreadPool& ThreadPool::get() {
+		static ThreadPool pool {std::max(1, (int) std::thread::hardware_concurrency() - 1)};
+		return pool;
+	}
+
+	ThreadPool::ThreadPool(int threads) {
+		for (int i = 0; i < threads; i ++) {
+			workers.emplace_back(&ThreadPool::run, this);
+		}
+	}
+
+	ThreadPool::~ThreadPool() {
+		{
+			std::lock_guard lock {mutex};
+			stopping = true;
+		}
+
+		condition.notify_all();
+
+		for (std::thread& worker : workers) {
+			worker.join();
+		}
+	}
+
+	void ThreadPool::submit(std::function<void()> task) {
+		{
+			std::lock_guard lock {mutex};
+			tasks.push_back(std::move(task));
+		}
+
+		condition.notify_one();
+	}
+
+	void ThreadPool::parallel(size_t count, size_t chunk, const std::function<void(size_t, size_t)>& body) {
+		const size_t chunks = (count + chunk - 1) / chunk;
+
+		if (chunks <= 1 || workers.empty()) {
+			body(0, count);
+			return;
+		}
+
+		struct Range {
+			std::atomic_size_t next = 0;
+			std::atomic_size_t finished = 0;
+			const std::function<void(size_t, size_t)>* body;
+			size_t count, chunk, chunks;
+
+			bool step() {
+				size_t index = next ++;
+
+				if (index >= chunks) {
+					return false;
+				}
+
+				size_t begin = index * chunk;
+				(*body)(begin, std::min(begin + chunk, count));
+				finished ++;
+				return true;
+			}
+		};
+
+		auto range = std::make_shared<Range>();
+		range->body = &body;
+		range->count = count;
+		range->chunk = chunk;
+		range->chunks = chunks;
+
+		// helpers that start late find no work left and exit without touching the body
+		const size_t helpers = std::min(chunks - 1, workers.size());
+
+		for (size_t i = 0; i < helpers; i ++) {
+			submit([range] () {
+				while (range->step());
+			});
+		}
+
+		while (range->step());
+
+		// wait for chunks still being processed by the helpers
+		while (range->finished < chunks) {
+			std::this_thread::yield();
+		}
+	}
+
+	int ThreadPool::size() const {
+		return workers.size();
+	}
+
+}
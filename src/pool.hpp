@@ -0,0 +1,46 @@
+#pragma once
+
+#include "external.hpp"
+
+namespace plgl::impl {
+
+	/**
+	 * Fixed set of worker threads executing tasks in submission order,
+	 * used for all background work (decoding, glyph generation, etc.)
+	 */
+	class ThreadPool {
+
+		private:
+
+			std::vector<std::thread> workers;
+			std::deque<std::function<void()>> tasks;
+			std::mutex mutex;
+			std::condition_variable condition;
+			bool stopping = false;
+
+			void run();
+
+		public:
+
+			/// Shared pool, started on first use, with one thread less than there are cores
+			static ThreadPool& get();
+
+			ThreadPool(int threads);
+			~ThreadPool();
+
+			/// Schedule task for execution on one of the worker threads
+			void submit(std::function<void()> task);
+
+			/**
+			 * Split the range [0, count) into chunks and process them on the worker threads,
+			 * the calling thread also takes part, returns once all chunks are done.
+			 * Safe to call from inside a worker as it never waits for a chunk that wasn't started
+			 */
+			void parallel(size_t count, size_t chunk, const std::function<void(size_t begin, size_t end)>& body);
+
+			/// Number of worker threads
+			int size() const;
+
+	};
+
+}
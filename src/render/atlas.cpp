@@ -1,5 +1,6 @@
 
 #include "atlas.hpp"
+#include "state.hpp"
 
 namespace plgl {
 
@@ -14,99 +15,150 @@ namespace plgl {
 		this->h = h;
 	}
 
-	Box2D Box2D::split_top_bottom(int height) {
-		int yn = this->y;
+	bool Box2D::empty() const {
+		return (w == 0) || (h == 0);
+	}
 
-		this->y += height;
-		this->h -= height;
+	bool Box2D::contains(const Box2D& other) const {
+		return other.x >= x && other.y >= y && other.x + other.w <= x + w && other.y + other.h <= y + h;
+	}
 
-		return {x, yn, w, height};
+	bool Box2D::intersects(const Box2D& other) const {
+		return other.x < x + w && other.x + other.w > x && other.y < y + h && other.y + other.h > y;
 	}
 
-	Box2D Box2D::split_left_right(int width) {
-		int xn = this->x;
+	/*
+	 * Packer
+	 */
 
-		this->x += width;
-		this->w -= width;
+	void Packer::split(const Box2D& placed) {
+		const size_t size = free.size();
 
-		return {xn, y, width, h};
-	}
+		for (size_t i = 0; i < size; i ++) {
+			Box2D box = free[i];
 
-	/// Check if no pixels are bound by this box
-	bool Box2D::empty() const {
-		return (w == 0) || (h == 0);
-	}
+			if (!box.intersects(placed)) {
+				continue;
+			}
 
-	/// allocate the given area from the box set
-	Box2D Box2D::allocate(std::list<Box2D>& boxes, int w, int h) {
+			// replace the box with up to four maximal boxes around the placed one
+			if (placed.x > box.x) {
+				free.emplace_back(box.x, box.y, placed.x - box.x, box.h);
+			}
 
-		for (auto it = boxes.begin(); it != boxes.end(); ++it) {
+			if (placed.x + placed.w < box.x + box.w) {
+				free.emplace_back(placed.x + placed.w, box.y, box.x + box.w - placed.x - placed.w, box.h);
+			}
 
-			Box2D& box = *it;
+			if (placed.y > box.y) {
+				free.emplace_back(box.x, box.y, box.w, placed.y - box.y);
+			}
 
-			// remove degenerate boxes
-			if (box.empty()) {
-				it = boxes.erase(it);
-				continue;
+			if (placed.y + placed.h < box.y + box.h) {
+				free.emplace_back(box.x, placed.y + placed.h, box.w, box.y + box.h - placed.y - placed.h);
 			}
 
-			// our box needs to fit first
-			if (box.w < w || box.h < h) {
+			free[i].w = 0;
+		}
+	}
+
+	void Packer::prune() {
+
+		// mark boxes that are fully covered by some other box
+		for (size_t i = 0; i < free.size(); i ++) {
+			if (free[i].empty()) {
 				continue;
 			}
 
-			// a happy little accident!
-			if (box.w == w && box.h == h) {
-				Box2D match = box;
-				boxes.erase(it);
-				return match;
+			for (size_t j = 0; j < free.size(); j ++) {
+				if (i != j && !free[j].empty() && free[j].contains(free[i])) {
+					free[i].w = 0;
+					break;
+				}
 			}
+		}
 
-			//  width
-			if (box.w == w) {
-				return box.split_top_bottom(h);
-			}
+		free.erase(std::remove_if(free.begin(), free.end(), [] (const Box2D& box) {
+			return box.empty();
+		}), free.end());
+	}
 
-			// height
-			if (box.h == h) {
-				return box.split_left_right(w);
+	Packer::Packer(int width, int height)
+	: w(width), h(height) {
+		free.emplace_back(0, 0, width, height);
+	}
+
+	Box2D Packer::allocate(int width, int height) {
+		Box2D best {0, 0, 0, 0};
+		int best_short = INT_MAX;
+		int best_long = INT_MAX;
+
+		for (const Box2D& box : free) {
+			if (box.w < width || box.h < height) {
+				continue;
 			}
 
-			Box2D left = box.split_left_right(w);
-			Box2D bottom = left.split_top_bottom(h);
+			int dw = box.w - width;
+			int dh = box.h - height;
+			int short_side = std::min(dw, dh);
+			int long_side = std::max(dw, dh);
+
+			if (short_side < best_short || (short_side == best_short && long_side < best_long)) {
+				best = {box.x, box.y, width, height};
+				best_short = short_side;
+				best_long = long_side;
+			}
+		}
 
-			boxes.push_front(left);
-			return bottom;
+		if (!best.empty()) {
+			split(best);
+			prune();
 
+			used += (size_t) width * height;
+			count ++;
 		}
 
-		return {0, 0, 0, 0};
+		return best;
+	}
 
+	float Packer::occupancy() const {
+		return used / (float) ((size_t) w * h);
 	}
 
-	/*
-	 * Sprite
-	 */
+	size_t Packer::allocated() const {
+		return count;
+	}
 
-	Sprite::Sprite(Texture* texture, int x, int y, int w, int h)
-	: texture(texture), x(x), y(y), w(w), h(h) {}
+	size_t Packer::fragments() const {
+		return free.size();
+	}
 
 	/*
 	 * Atlas
 	 */
 
-	Sprite Atlas::packSprite(Image& image, const std::function<void()>& on_resize) {
+	Atlas::Page& Atlas::addPage() {
+		Page& page = pages.emplace_back(Image::allocate(size, size), Packer {size, size});
+		page.image.clear({0, 0, 0, 0});
 
-		Box2D box = Box2D::allocate(this->pool, image.width(), image.height());
+		// texture storage starts out undefined, the whole layer is uploaded so that
+		// filtering at the edges of sprites never samples outside of the cleared page
+		invalidate((int) pages.size() - 1, 0, 0, size, size);
 
-//		for (Box2D box : pool) {
-//			atlas.fill(box.x, box.y, box.w, box.h, {0, 0, 0, 255});
-//			atlas.fill(box.x + 3, box.y + 3, box.w - 6, box.h - 6, {255, 255, 255, 255});
-//		}
+		return page;
+	}
 
-		if (!box.empty()) {
-			atlas.blit(box.x, box.y, image);
-			return {this, box.x, box.y, box.w, box.h};
+	Sprite Atlas::packSprite(int w, int h, const std::function<void()>& on_resize) {
+		if (w > size || h > size) {
+			fault("Can't fit image of size ({}, {}) into atlas of size ({}, {})!", w, h, size, size);
+		}
+
+		for (int layer = 0; layer < (int) pages.size(); layer ++) {
+			Box2D box = pages[layer].packer.allocate(w, h);
+
+			if (!box.empty()) {
+				return {this, box.x, box.y, box.w, box.h, layer};
+			}
 		}
 
 		// notify caller
@@ -114,49 +166,225 @@ namespace plgl {
 			on_resize();
 		}
 
-		int w = atlas.width();
-		int h = atlas.width();
+		Box2D box = addPage().packer.allocate(w, h);
+		return {this, box.x, box.y, box.w, box.h, (int) pages.size() - 1};
+	}
+
+	void Atlas::allocate() {
+		int layers = std::max(1, capacity);
+
+		// grow geometrically so that new textures are rarely needed
+		while (layers < (int) pages.size()) {
+			layers *= 2;
+		}
+
+		GLuint previous = tid;
+		glGenTextures(1, &tid);
 
-		// retry with bigger atlas
-		pool.emplace_back(w, 0, w, h);
-		pool.emplace_back(0, h, 2 * w, h);
-		atlas.resize(w + w, h + h);
+		apply();
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, 0);
 
-		return packSprite(image, {});
+		if (GLAD_GL_VERSION_4_2 || GLAD_GL_ARB_texture_storage) {
+			glTexStorage3D(GL_TEXTURE_2D_ARRAY, 1, GL_RGBA8, size, size, layers);
+		} else {
+			glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, size, size, layers, 0, format(c), GL_UNSIGNED_BYTE, nullptr);
+		}
+
+		// existing layers can be copied on the GPU, otherwise they are uploaded again
+		if (capacity > 0 && (GLAD_GL_VERSION_4_3 || GLAD_GL_ARB_copy_image)) {
+			glCopyImageSubData(previous, GL_TEXTURE_2D_ARRAY, 0, 0, 0, 0, tid, GL_TEXTURE_2D_ARRAY, 0, 0, 0, 0, size, size, capacity);
+		} else {
+			for (int layer = 0; layer < std::min(capacity, (int) pages.size()); layer ++) {
+				invalidate(layer, 0, 0, size, size);
+			}
+		}
+
+		// the texture created by the Texture constructor was never an array
+		impl::GLState::deleteTexture(previous);
+		this->capacity = layers;
 	}
 
-	Atlas::Atlas() {
-		atlas = Image::allocate(512, 512);
-		pool.emplace_back(0, 0, 512, 512);
+	Atlas::Atlas(int size)
+	: size(size) {
+		this->c = 4;
+		this->w = size;
+		this->h = size;
+		this->sampling.wrap = Sampler::CLAMP;
+
+		addPage();
 	}
 
 	void Atlas::close() {
-		atlas.close();
+		for (Page& page : pages) {
+			page.image.close();
+		}
+
+		pages.clear();
 		Texture::close();
 	}
 
-	Image& Atlas::getImage() {
-		return atlas;
+	Image& Atlas::getImage(int layer) {
+		return pages.at(layer).image;
 	}
 
 	void Atlas::upload() {
-		Texture::upload(atlas);
+		if (capacity < (int) pages.size()) {
+			allocate();
+		}
+
+		if (dirty.empty()) {
+			return;
+		}
+
+		impl::GLState::bindTexture(GL_TEXTURE_2D_ARRAY, tid);
+		glPixelStorei(GL_UNPACK_ROW_LENGTH, size);
+
+		for (Region& region : dirty) {
+			const Box2D& box = region.box;
+			const uint8_t* pixels = (const uint8_t*) pages[region.layer].image.data();
+			const uint8_t* start = pixels + (box.y * size + box.x) * c;
+
+			glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, box.x, box.y, region.layer, box.w, box.h, 1, format(c), GL_UNSIGNED_BYTE, start);
+		}
+
+		glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+		dirty.clear();
+	}
+
+	void Atlas::invalidate(int layer, int x, int y, int w, int h) {
+		dirty.push_back({layer, {x, y, w, h}});
+	}
+
+	void Atlas::use() {
+		upload();
+		impl::GLState::bindTexture(GL_TEXTURE_2D_ARRAY, tid);
+	}
+
+	int Atlas::width() const {
+		return size;
+	}
+
+	int Atlas::height() const {
+		return size;
+	}
+
+	bool Atlas::layered() const {
+		return true;
 	}
 
 	void Atlas::save(const std::string& path) const {
-		atlas.save(path);
+		Image image = Image::allocate(size, size * pages.size());
+
+		for (size_t layer = 0; layer < pages.size(); layer ++) {
+			image.blit(0, layer * size, pages[layer].image);
+		}
+
+		image.save(path);
+		image.close();
 	}
 
 	Sprite Atlas::submit(const std::string& path, const std::function<void()>& on_resize) {
-		Image image = Image::load(path);
-		Sprite sprite = submit(image, on_resize);
-		image.close();
+		return submit(Image::load(path), on_resize);
+	}
+
+	Sprite Atlas::submit(const ImageView& image, const std::function<void()>& on_resize) {
+		Sprite sprite = packSprite(image.width(), image.height(), on_resize);
+
+		pages[sprite.layer].image.blit(sprite.x, sprite.y, image);
+		invalidate(sprite.layer, sprite.x, sprite.y, sprite.w, sprite.h);
 
 		return sprite;
 	}
 
-	Sprite Atlas::submit(Image& image, const std::function<void()>& on_resize) {
-		return packSprite(image, on_resize);
+	std::vector<Sprite> Atlas::submit(const std::vector<ImageView>& images, const std::function<void()>& on_resize) {
+		std::vector<size_t> order (images.size());
+		std::vector<Sprite> sprites (images.size());
+
+		for (size_t i = 0; i < order.size(); i ++) {
+			order[i] = i;
+		}
+
+		// placing big images first leaves much less unusable space
+		std::sort(order.begin(), order.end(), [&] (size_t a, size_t b) {
+			const ImageView& ia = images[a];
+			const ImageView& ib = images[b];
+			return std::max(ia.width(), ia.height()) > std::max(ib.width(), ib.height());
+		});
+
+		bool notified = false;
+
+		for (size_t index : order) {
+			const ImageView& image = images[index];
+
+			sprites[index] = packSprite(image.width(), image.height(), notified ? std::function<void()> {} : [&] () {
+				if (on_resize) on_resize();
+				notified = true;
+			});
+		}
+
+		for (size_t i = 0; i < images.size(); i ++) {
+			Sprite& sprite = sprites[i];
+
+			pages[sprite.layer].image.blit(sprite.x, sprite.y, images[i]);
+			invalidate(sprite.layer, sprite.x, sprite.y, sprite.w, sprite.h);
+		}
+
+		return sprites;
+	}
+
+	float Atlas::occupancy() const {
+		float sum = 0;
+
+		for (const Page& page : pages) {
+			sum += page.packer.occupancy();
+		}
+
+		return sum / pages.size();
+	}
+
+	size_t Atlas::sprites() const {
+		size_t count = 0;
+
+		for (const Page& page : pages) {
+			count += page.packer.allocated();
+		}
+
+		return count;
+	}
+
+	int Atlas::layers() const {
+		return pages.size();
+	}
+
+	/*
+	 * TextureAtlas
+	 */
+
+	int impl::TextureAtlas::threshold = 0;
+	Atlas* impl::TextureAtlas::atlas = nullptr;
+
+	void impl::TextureAtlas::enable(int threshold) {
+		TextureAtlas::threshold = threshold;
+	}
+
+	bool impl::TextureAtlas::accepts(const ImageView& image) {
+		return image.channels() == 4 && (int) image.width() <= threshold && (int) image.height() <= threshold;
+	}
+
+	Sprite impl::TextureAtlas::submit(const ImageView& image) {
+		if (atlas == nullptr) {
+			atlas = new Atlas(std::max(1024, threshold));
+		}
+
+		return atlas->submit(image);
+	}
+
+	void impl::TextureAtlas::close() {
+		if (atlas) {
+			atlas->close();
+			delete atlas;
+			atlas = nullptr;
+		}
 	}
 
-}
\ No newline at end of file
+}
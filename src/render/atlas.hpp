@@ -11,52 +11,160 @@ namespace plgl {
 
 		Box2D(int x, int y, int w, int h);
 
-		/// Split this box into it's top and bottom parts
-		Box2D split_top_bottom(int offset);
-
-		/// Split this box into it's left and right parts
-		Box2D split_left_right(int offset);
-
 		/// Check if no pixels are bound by this box
 		bool empty() const;
 
-		/// Allocate area from pool
-		static Box2D allocate(std::list<Box2D>& boxes, int w, int h);
+		/// Check if the other box lies completely inside this one
+		bool contains(const Box2D& other) const;
+
+		/// Check if the two boxes share any pixels
+		bool intersects(const Box2D& other) const;
 
 	};
 
-	struct Sprite {
+	/**
+	 * MaxRects rectangle packer, keeps a list of maximal (possibly overlapping)
+	 * free rectangles and places each box into the free rectangle that leaves
+	 * the shortest leftover side (best-short-side-fit)
+	 */
+	class Packer {
 
-		Texture* texture;
-		int x, y, w, h;
+		private:
+
+			std::vector<Box2D> free;
+			int w, h;
+			size_t used = 0;
+			size_t count = 0;
+
+			void split(const Box2D& placed);
+			void prune();
+
+		public:
 
-		Sprite() = default;
-		Sprite(Texture* texture, int x, int y, int w, int h);
+			Packer(int width, int height);
+
+			/// Allocate area from the free space, returns an empty box if it doesn't fit
+			Box2D allocate(int width, int height);
+
+			/// Fraction of the total area that is allocated
+			float occupancy() const;
+
+			/// Number of allocated boxes
+			size_t allocated() const;
+
+			/// Number of free rectangles tracked
+			size_t fragments() const;
 
 	};
 
+	/**
+	 * Texture array containing many smaller images, each layer (page) of the array is
+	 * packed separately and new layers are added once all existing ones are full, so sprites
+	 * never move and can all be drawn in one batch no matter on which page they are
+	 */
 	class Atlas : public Texture {
 
 		private:
 
-			Image atlas;
-			std::list<Box2D> pool;
+			struct Page {
+				Image image;
+				Packer packer;
+			};
+
+			struct Region {
+				int layer;
+				Box2D box;
+			};
 
-			Sprite packSprite(Image& image, const std::function<void()>& on_resize);
+			int size;
+			int capacity = 0;
+			std::vector<Page> pages;
+
+			// regions of the pages not yet copied to the texture
+			std::vector<Region> dirty;
+
+			Page& addPage();
+			Sprite packSprite(int w, int h, const std::function<void()>& on_resize);
+			void allocate();
 
 		public:
 
-			Atlas();
+			Atlas(int size = 1024);
 			void close();
 
 		public:
 
-			Image& getImage();
+			/// Get the image of the given page
+			Image& getImage(int layer = 0);
+
+			/// Copy all modified regions of the pages into the texture, done automatically by use()
 			void upload();
+
+			/// Mark a region of a page as modified
+			void invalidate(int layer, int x, int y, int w, int h);
+
+			void use() override;
+			int width() const override;
+			int height() const override;
+			bool layered() const override;
+
+			/// Save all pages, one below the other, into a single image file
 			void save(const std::string& path) const final;
+
 			Sprite submit(const std::string& path, const std::function<void()>& on_resize = {});
-			Sprite submit(Image& image, const std::function<void()>& on_resize = {});
+			Sprite submit(const ImageView& image, const std::function<void()>& on_resize = {});
+
+			/**
+			 * @brief Add many images at once.
+			 *
+			 * Places all the images first, largest first, and only then copies them
+			 * into the atlas, this packs better than submitting them one by one.
+			 *
+			 * @param[in] images    Images to add, all with the same channel count as the atlas
+			 * @param[in] on_resize Called before a new page is added
+			 */
+			std::vector<Sprite> submit(const std::vector<ImageView>& images, const std::function<void()>& on_resize = {});
+
+			/// Fraction of the total page area that is used by sprites
+			float occupancy() const;
+
+			/// Number of sprites in this atlas
+			size_t sprites() const;
+
+			/// Number of pages (texture layers) in this atlas
+			int layers() const;
 
 	};
 
+	namespace impl {
+
+		/**
+		 * Shared atlas into which small textures are placed
+		 * automatically when they are loaded, see plgl::texture_atlas()
+		 */
+		class TextureAtlas {
+
+			private:
+
+				static int threshold;
+				static Atlas* atlas;
+
+			public:
+
+				/// Set the maximum size of atlased textures, 0 disables atlasing
+				static void enable(int threshold);
+
+				/// Check if the given image should be placed in the shared atlas
+				static bool accepts(const ImageView& image);
+
+				/// Place the given image in the shared atlas
+				static Sprite submit(const ImageView& image);
+
+				/// Free the shared atlas, all textures placed in it become invalid
+				static void close();
+
+		};
+
+	}
+
 }
@@ -1,49 +1,180 @@
 
 #include "basic.hpp"
+#include "state.hpp"
 
 namespace plgl::impl {
 
+	// each triangle moves 4 units of a 24 bit depth buffer closer to the viewer
+	static constexpr int depth_limit = 1 << 22;
+	static constexpr float depth_step = 2.0f / depth_limit;
+
 	/*
 	 * BasicRenderer
 	 */
 
+	void BasicRenderer::applyClip() {
+		clipping = false;
+
+		if (clip_method == CLIP_SCISSOR) {
+			flush();
+
+			if (clips.empty()) {
+				glScissor(0, 0, width, height);
+				return;
+			}
+
+			// A (x0, y0)
+			// |
+			// X--B (x1, y1)
+			//
+			// then, X (x0, y1)
+			//       w = |XB|
+			//       h = |XA|
+
+			const ClipRect& rect = clips.back();
+			glScissor((int) rect.x0, (int) (height - rect.y1), (int) (rect.x1 - rect.x0), (int) (rect.y1 - rect.y0));
+			return;
+		}
+
+		if (!clips.empty()) {
+			const ClipRect& rect = clips.back();
+
+			// screen Y axis points down, NDC Y axis points up
+			clip_ndc = {remapx(rect.x0), remapy(rect.y1), remapx(rect.x1), remapy(rect.y0)};
+			clipping = true;
+		}
+	}
+
+	Buffer& BasicRenderer::target(bool opaque) {
+		if (!depth_sorting) {
+			return pipeline->buffer;
+		}
+
+		// every triangle gets its own depth, later triangles are closer
+		if (corner == 0) {
+
+			// we are running out of depth precision, start over
+			if (depth_index >= depth_limit) {
+				flush();
+				glClear(GL_DEPTH_BUFFER_BIT);
+				depth_index = 0;
+			}
+
+			depth = 1.0f - (++ depth_index) * depth_step;
+		}
+
+		corner = (corner + 1) % 3;
+
+		// custom effects can output translucent pixels
+		if (opaque && !pipeline->effect) {
+			if (pipeline->opaque.empty()) {
+				opaque_pending.push_back(pipeline);
+			}
+
+			return pipeline->opaque;
+		}
+
+		// translucent triangles must be drawn in order, after
+		// all opaque triangles that were submitted before them
+		if (translucent != pipeline) {
+			flush();
+			translucent = pipeline;
+		}
+
+		return pipeline->buffer;
+	}
+
+	void BasicRenderer::flushOpaque() {
+		GLState::depthMask(true);
+
+		for (Pipeline* pending : opaque_pending) {
+			pending->flush(pending->opaque);
+		}
+
+		opaque_pending.clear();
+	}
+
+	BasicRenderer::BasicRenderer() {
+		updatePipelines();
+	}
+
 	BasicRenderer::~BasicRenderer() {
-		delete color_pipeline;
+		// do nothing
 	}
 
 	void BasicRenderer::use(Pipeline* pipeline) {
 		if (this->pipeline != pipeline) {
-			flush();
+
+			// with depth sorting batches are only broken by translucent geometry
+			if (!depth_sorting) {
+				flush();
+			}
+
 			this->pipeline = pipeline;
 		}
 	}
 
 	void BasicRenderer::svert(float x, float y) {
-		pipeline->buffer.vertex(x, y, sr, sg, sb, sa);
+		Buffer& buffer = target(sa >= 255);
+		buffer.vertex(x, y, depth, sr, sg, sb, sa);
+		if (clipping) buffer.clip(clip_ndc);
 	}
 
 	void BasicRenderer::fvert(float x, float y) {
-		pipeline->buffer.vertex(x, y, fr, fg, fb, fa);
+		Buffer& buffer = target(fa >= 255);
+		buffer.vertex(x, y, depth, fr, fg, fb, fa);
+		if (clipping) buffer.clip(clip_ndc);
 	}
 
-	void BasicRenderer::ivert(float x, float y, float u, float v) {
-		pipeline->buffer.vertex(x, y, u, v, tr, tg, tb, ta);
+	void BasicRenderer::ivert(float x, float y, float u, float v, float w) {
+		Buffer& buffer = target(ta >= 255 && image_opaque && pipeline == image_pipeline);
+		buffer.vertex(x, y, depth, u, v, w, tr, tg, tb, ta);
+		if (clipping) buffer.clip(clip_ndc);
 	}
 
 	float BasicRenderer::getStrokeWidth() {
 		return stroke_flag ? stroke_width : 0;
 	}
 
+	bool BasicRenderer::isDepthSorting() const {
+		return depth_sorting;
+	}
+
 	PixelBuffer& BasicRenderer::getTexture() {
 		return *pipeline->texture;
 	}
 
-	void BasicRenderer::registerTexture(PixelBuffer& texture, Shader& shader) {
-		textures.emplace(
-		std::piecewise_construct,
-		std::forward_as_tuple(texture.handle()),
-		std::forward_as_tuple(shader, &texture)
-		);
+	Pipeline* BasicRenderer::getPipeline(Shader& shader, PixelBuffer* texture, Effect* effect) {
+		auto key = std::make_pair(shader.handle(), texture);
+		auto it = pipelines.find(key);
+
+		if (it == pipelines.end()) {
+			it = pipelines.emplace(
+			std::piecewise_construct,
+			std::forward_as_tuple(key),
+			std::forward_as_tuple(shader, texture, effect)
+			).first;
+		}
+
+		return &it->second;
+	}
+
+	void BasicRenderer::updatePipelines() {
+		if (effect) {
+			color_pipeline = getPipeline(effect->getShader(Effect::SHAPE), nullptr, effect);
+		} else {
+			color_pipeline = getPipeline(Pipeline::getColorShader(), nullptr, nullptr);
+		}
+
+		if (image_texture) {
+			bool layered = image_texture->layered();
+
+			if (effect) {
+				image_pipeline = getPipeline(effect->getShader(layered ? Effect::IMAGE_ARRAY : Effect::IMAGE), image_texture, effect);
+			} else {
+				image_pipeline = getPipeline(Pipeline::getImageShader(layered), image_texture, nullptr);
+			}
+		}
 	}
 
 	void BasicRenderer::drawStrokeSegment(const Vec2& pa, const Vec2& pb, const Vec2& pc) {
@@ -98,55 +229,157 @@ namespace plgl::impl {
 	}
 
 	void BasicRenderer::useTexture(Texture& t) {
-		GLuint tid = t.handle();
+		this->image_texture = &t;
+		this->image_opaque = depth_sorting && t.opaque();
+		updatePipelines();
+	}
 
-		if (!textures.count(tid)) {
-			registerTexture(t, Pipeline::getImageShader());
-		}
+	void BasicRenderer::useFont(Font& f) {
+		this->fonts_pipeline = getPipeline(Pipeline::getFontShader(), &f.getAtlas(), nullptr);
+	}
 
-		this->image_pipeline = &textures.at(tid);
+	void BasicRenderer::useEffect(Effect* e) {
+		this->effect = e;
+		updatePipelines();
 	}
 
-	void BasicRenderer::useFont(Font& f) {
-		GLuint tid = f.handle();
+	void BasicRenderer::releaseEffect(Effect* e) {
+
+		// batched geometry still needs the effect shaders to be drawn
+		flush();
+
+		if (pipeline != nullptr && pipeline->effect == e) {
+			pipeline = nullptr;
+		}
+
+		std::erase_if(pipelines, [e] (const auto& entry) {
+			return entry.second.effect == e;
+		});
 
-		if (!textures.count(tid)) {
-			registerTexture(f, Pipeline::getFontShader());
+		filters.remove(e);
+
+		if (effect == e) {
+			effect = nullptr;
 		}
 
-		this->fonts_pipeline = &textures.at(tid);
+		// selected pipelines may have been removed
+		updatePipelines();
 	}
 
 	void BasicRenderer::flush() {
+		if (depth_sorting) {
+			flushOpaque();
+
+			if (translucent != nullptr) {
+				GLState::depthMask(false);
+				translucent->flush();
+				translucent = nullptr;
+			}
+
+			return;
+		}
+
 		if (this->pipeline != nullptr) {
 			this->pipeline->flush();
 		}
 	}
 
+	void BasicRenderer::beginFrame() {
+		filters.begin();
+
+		// the clip is kept in window coordinates, recompute it in case the window was resized
+		applyClip();
+
+		if (depth_sorting) {
+			GLState::depthMask(true);
+			glClear(GL_DEPTH_BUFFER_BIT);
+			depth_index = 0;
+		}
+	}
+
+	void BasicRenderer::endFrame() {
+		flush();
+		filters.end();
+	}
+
 	void BasicRenderer::clip(float x1, float y1, float x2, float y2) {
+		clips.clear();
+		clips.push_back({std::min(x1, x2), std::min(y1, y2), std::max(x1, x2), std::max(y1, y2)});
+		applyClip();
+	}
+
+	void BasicRenderer::clip(Disabled disabled) {
+		clips.clear();
+		applyClip();
+	}
+
+	void BasicRenderer::clip_push(float x1, float y1, float x2, float y2) {
+		ClipRect rect {std::min(x1, x2), std::min(y1, y2), std::max(x1, x2), std::max(y1, y2)};
+
+		// nested clips can only shrink the visible area
+		if (!clips.empty()) {
+			const ClipRect& top = clips.back();
+
+			rect.x0 = std::max(rect.x0, top.x0);
+			rect.y0 = std::max(rect.y0, top.y0);
+			rect.x1 = std::max(rect.x0, std::min(rect.x1, top.x1));
+			rect.y1 = std::max(rect.y0, std::min(rect.y1, top.y1));
+		}
+
+		clips.push_back(rect);
+		applyClip();
+	}
 
-		float x_min = std::min(x1, x2);
-		float y_min = std::min(y1, y2);
-		float x_max = std::max(x1, x2);
-		float y_max = std::max(y1, y2);
+	void BasicRenderer::clip_pop() {
+		if (clips.empty()) {
+			fault("Can't pop clip rectangle, the clip stack is empty!");
+		}
 
-		// A (x_min, y_min)
-		// |
-		// X--B (x_max, y_max)
-		//
-		// then, X (x_min, y_max)
-		//       w = |XB|
-		//       h = |XA|
+		clips.pop_back();
+		applyClip();
+	}
 
-		float w = x_max - x_min;
-		float h = y_max - y_min;
+	void BasicRenderer::depth_sort(bool enable) {
+		if (depth_sorting == enable) {
+			return;
+		}
 
 		flush();
-		glScissor((int) x_min, (int) (height - y_max), (int) w, (int) h);
+
+		if (enable) {
+			GLint bound = 0;
+			GLint bits = 0;
+			glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &bound);
+			glGetFramebufferAttachmentParameteriv(GL_DRAW_FRAMEBUFFER, bound ? GL_DEPTH_ATTACHMENT : GL_DEPTH, GL_FRAMEBUFFER_ATTACHMENT_DEPTH_SIZE, &bits);
+
+			if (bits < 24) {
+				fault("Depth sorting requires a 24 bit depth buffer, but the current framebuffer has {} bits!", bits);
+			}
+
+			glEnable(GL_DEPTH_TEST);
+			glDepthFunc(GL_LESS);
+			GLState::depthMask(true);
+			glClear(GL_DEPTH_BUFFER_BIT);
+		} else {
+			glDisable(GL_DEPTH_TEST);
+			GLState::depthMask(true);
+		}
+
+		depth_sorting = enable;
+		depth_index = 0;
+		corner = 0;
+		depth = -1.0f;
 	}
 
-	void BasicRenderer::clip(Disabled disabled) {
-		clip(0, 0, width, height);
+	void BasicRenderer::clip_mode(ClipMode mode) {
+		if (clip_method != mode) {
+			flush();
+
+			// remove any left over scissor when switching away from it
+			glScissor(0, 0, width, height);
+			clip_method = mode;
+			applyClip();
+		}
 	}
 
 }
\ No newline at end of file
@@ -7,6 +7,9 @@
 #include "font.hpp"
 #include "color.hpp"
 #include "math.hpp"
+#include "effect.hpp"
+#include "filter.hpp"
+#include "clip.hpp"
 
 namespace plgl::impl {
 
@@ -17,13 +20,41 @@ namespace plgl::impl {
 			// currently used pipeline
 			Pipeline* pipeline = nullptr;
 
+			// clip stack in screen space, the last rectangle is the active one
+			std::vector<ClipRect> clips;
+			ClipMode clip_method = CLIP_GEOMETRY;
+			ClipRect clip_ndc;
+			bool clipping = false;
+
+			void applyClip();
+
+			// depth sorting state, see depth_sort()
+			bool depth_sorting = false;
+			int depth_index = 0;
+			int corner = 0;
+			float depth = -1.0f;
+			Pipeline* translucent = nullptr;
+			std::vector<Pipeline*> opaque_pending;
+
+			Buffer& target(bool opaque);
+			void flushOpaque();
+
 		protected:
 
-			Pipeline* color_pipeline = new Pipeline {Pipeline::getColorShader(), nullptr};
+			Pipeline* color_pipeline = nullptr;
 			Pipeline* image_pipeline = nullptr;
 			Pipeline* fonts_pipeline = nullptr;
 
-			std::unordered_map<GLuint, Pipeline> textures;
+			// pipelines keyed by shader program and texture object, GL texture
+			// handles can't be used here as an atlas gets a new one each time it grows
+			std::map<std::pair<GLuint, PixelBuffer*>, Pipeline> pipelines;
+
+			// user effect and texture used to select the image pipeline
+			Effect* effect = nullptr;
+			Texture* image_texture = nullptr;
+			bool image_opaque = false;
+
+			FilterChain filters;
 
 			float sr, sg, sb, sa; // stroke
 			float fr, fg, fb, fa; // fill
@@ -35,17 +66,20 @@ namespace plgl::impl {
 
 		protected:
 
+			BasicRenderer();
 			virtual ~BasicRenderer();
 
 			void use(Pipeline* pipeline);
 
 			void svert(float x, float y);
 			void fvert(float x, float y);
-			void ivert(float x, float y, float u, float v);
+			void ivert(float x, float y, float u, float v, float w);
 
 			float getStrokeWidth();
+			bool isDepthSorting() const;
 			PixelBuffer& getTexture();
-			void registerTexture(PixelBuffer& texture, Shader& shader);
+			Pipeline* getPipeline(Shader& shader, PixelBuffer* texture, Effect* effect);
+			void updatePipelines();
 			void drawStrokeSegment(const Vec2& pa, const Vec2& pb, const Vec2& pc);
 			void drawFillQuad(float x1, float y1, float x2, float y2, float x3, float y3, float x4, float y4);
 			void drawStrokeQuad(float x1, float y1, float x2, float y2, float x3, float y3, float x4, float y4);
@@ -54,9 +88,19 @@ namespace plgl::impl {
 
 			void useTexture(Texture& t);
 			void useFont(Font& f);
+			void useEffect(Effect* e);
+
+			/// Drop all pipelines and filters using the given effect, called when the effect is destroyed
+			void releaseEffect(Effect* e);
 			void flush();
+			void beginFrame();
+			void endFrame();
 			void clip(float x1, float y1, float x2, float y2);
 			void clip(Disabled disabled);
+			void clip_push(float x1, float y1, float x2, float y2);
+			void clip_pop();
+			void clip_mode(ClipMode mode);
+			void depth_sort(bool enable);
 
 	};
 
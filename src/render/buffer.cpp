@@ -1,5 +1,6 @@
 
 #include "buffer.hpp"
+#include "state.hpp"
 
 namespace plgl {
 
@@ -7,8 +8,23 @@ namespace plgl {
 	 * Vertex
 	 */
 
-	Vertex::Vertex(float x, float y, float u, float v, uint8_t r, uint8_t g, uint8_t b, uint8_t a)
-	: x(x), y(y), u(u), v(v), r(r), g(g), b(b), a(a) {}
+	Vertex::Vertex(float x, float y, float z, float u, float v, float w, uint8_t r, uint8_t g, uint8_t b, uint8_t a)
+	: x(x), y(y), z(z), u(u), v(v), w(w), r(r), g(g), b(b), a(a) {}
+
+	Vertex Vertex::lerp(const Vertex& a, const Vertex& b, float t) {
+		auto mix = [t] (float x, float y) {
+			return x + (y - x) * t;
+		};
+
+		auto mixb = [t] (uint8_t x, uint8_t y) {
+			return (uint8_t) std::lround(x + (y - x) * t);
+		};
+
+		return {
+			mix(a.x, b.x), mix(a.y, b.y), mix(a.z, b.z), mix(a.u, b.u), mix(a.v, b.v), a.w,
+			mixb(a.r, b.r), mixb(a.g, b.g), mixb(a.b, b.b), mixb(a.a, b.a)
+		};
+	}
 
 	/*
 	 * Buffer
@@ -20,32 +36,58 @@ namespace plgl {
 	}
 
 	void Buffer::upload() {
-		glBindBuffer(GL_ARRAY_BUFFER, vbo);
+		impl::GLState::bindBuffer(GL_ARRAY_BUFFER, vbo);
 		glBufferData(GL_ARRAY_BUFFER, buffer.size() * sizeof(Vertex), buffer.data(), GL_DYNAMIC_DRAW);
 	}
 
+	int Buffer::clipEdge(const Vertex* input, int count, Vertex* output, int axis, float bound, float sign) {
+		int written = 0;
+
+		auto distance = [=] (const Vertex& vertex) {
+			return ((axis == 0) ? vertex.x - bound : vertex.y - bound) * sign;
+		};
+
+		for (int i = 0; i < count; i ++) {
+			const Vertex& current = input[i];
+			const Vertex& next = input[(i + 1) % count];
+
+			float dc = distance(current);
+			float dn = distance(next);
+
+			if (dc >= 0) {
+				output[written ++] = current;
+			}
+
+			// edge crosses the clip line
+			if ((dc >= 0) != (dn >= 0)) {
+				output[written ++] = Vertex::lerp(current, next, dc / (dc - dn));
+			}
+		}
+
+		return written;
+	}
+
 	Buffer::Buffer() {
 		// create and bind VAO
 		glGenVertexArrays(1, &vao);
-		glBindVertexArray(vao);
+		impl::GLState::bindVertexArray(vao);
 
 		// create and fill VBO
 		glGenBuffers(1, &vbo);
-		glBindBuffer(GL_ARRAY_BUFFER, vbo);
+		impl::GLState::bindBuffer(GL_ARRAY_BUFFER, vbo);
 
 		// configure VAO
-		vertexAttribute(0, 2, stride, 0 * sizeof(float), GL_FLOAT, false); // vec2: xy
-		vertexAttribute(1, 2, stride, 2 * sizeof(float), GL_FLOAT, false); // vec2: uv
-		vertexAttribute(2, 4, stride, 4 * sizeof(float), GL_UNSIGNED_BYTE, true); // vec4: rgba
+		vertexAttribute(0, 3, stride, 0 * sizeof(float), GL_FLOAT, false); // vec3: xyz
+		vertexAttribute(1, 3, stride, 3 * sizeof(float), GL_FLOAT, false); // vec3: uvw
+		vertexAttribute(2, 4, stride, 6 * sizeof(float), GL_UNSIGNED_BYTE, true); // vec4: rgba
 
 		// cleanup global state
-		glBindVertexArray(0);
-		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		impl::GLState::bindVertexArray(0);
 	}
 
 	Buffer::~Buffer() {
-		glDeleteVertexArrays(1, &vao);
-		glDeleteBuffers(1, &vbo);
+		impl::GLState::deleteVertexArray(vao);
+		impl::GLState::deleteBuffer(vbo);
 	}
 
 	void Buffer::clear() {
@@ -58,20 +100,62 @@ namespace plgl {
 
 	void Buffer::draw() {
 		upload();
-		glBindVertexArray(vao);
+		impl::GLState::bindVertexArray(vao);
 		glDrawArrays(GL_TRIANGLES, 0, buffer.size());
 	}
 
-	void Buffer::vertex(float x, float y, float u, float v, uint8_t r, uint8_t g, uint8_t b, uint8_t a) {
+	void Buffer::vertex(float x, float y, float z, float u, float v, float w, uint8_t r, uint8_t g, uint8_t b, uint8_t a) {
 		buffer.emplace_back(
 			plgl::impl::remapx(x),
 			plgl::impl::remapy(y),
-			u, v, r, g, b, a
+			z, u, v, w, r, g, b, a
 		);
 	}
 
-	void Buffer::vertex(float x, float y, uint8_t r, uint8_t g, uint8_t b, uint8_t a) {
-		vertex(x, y, 0, 0, r, g, b, a);
+	void Buffer::vertex(float x, float y, float z, uint8_t r, uint8_t g, uint8_t b, uint8_t a) {
+		vertex(x, y, z, 0, 0, 0, r, g, b, a);
+	}
+
+	void Buffer::clip(const ClipRect& rect) {
+		if (buffer.size() % 3 != 0) {
+			return;
+		}
+
+		const size_t base = buffer.size() - 3;
+		const Vertex* triangle = buffer.data() + base;
+
+		float min_x = std::min({triangle[0].x, triangle[1].x, triangle[2].x});
+		float max_x = std::max({triangle[0].x, triangle[1].x, triangle[2].x});
+		float min_y = std::min({triangle[0].y, triangle[1].y, triangle[2].y});
+		float max_y = std::max({triangle[0].y, triangle[1].y, triangle[2].y});
+
+		// fast path, most triangles are either fully inside or fully outside
+		if (min_x >= rect.x0 && max_x <= rect.x1 && min_y >= rect.y0 && max_y <= rect.y1) {
+			return;
+		}
+
+		if (max_x <= rect.x0 || min_x >= rect.x1 || max_y <= rect.y0 || min_y >= rect.y1) {
+			buffer.resize(base);
+			return;
+		}
+
+		// a triangle clipped by four planes has at most 7 vertices
+		Vertex a[8], b[8];
+		std::copy(triangle, triangle + 3, a);
+		buffer.resize(base);
+
+		int count = 3;
+		count = clipEdge(a, count, b, 0, rect.x0, +1);
+		count = clipEdge(b, count, a, 0, rect.x1, -1);
+		count = clipEdge(a, count, b, 1, rect.y0, +1);
+		count = clipEdge(b, count, a, 1, rect.y1, -1);
+
+		// convex polygon, emit as a triangle fan
+		for (int i = 1; i < count - 1; i ++) {
+			buffer.push_back(a[0]);
+			buffer.push_back(a[i]);
+			buffer.push_back(a[i + 1]);
+		}
 	}
 
 }
\ No newline at end of file
@@ -5,13 +5,22 @@
 namespace plgl {
 
 	struct Vertex {
-		float x, y, u, v;
+		float x, y, z, u, v, w;
 		uint8_t r, g, b, a;
 
-		Vertex(float x, float y, float u, float v, uint8_t r, uint8_t g, uint8_t b, uint8_t a);
+		Vertex() = default;
+		Vertex(float x, float y, float z, float u, float v, float w, uint8_t r, uint8_t g, uint8_t b, uint8_t a);
+
+		/// Linearly interpolate all vertex attributes
+		static Vertex lerp(const Vertex& a, const Vertex& b, float t);
+	};
+
+	/// Axis aligned clip rectangle, with x0 <= x1 and y0 <= y1
+	struct ClipRect {
+		float x0, y0, x1, y1;
 	};
 
-	static_assert(sizeof(Vertex) == 5 * 4, "Invalid Vertex size!");
+	static_assert(sizeof(Vertex) == 7 * 4, "Invalid Vertex size!");
 
 	class Buffer {
 
@@ -26,6 +35,9 @@ namespace plgl {
 			void vertexAttribute(int index, int count, int stride, long offset, GLenum type, bool normalize);
 			void upload();
 
+			/// Clip polygon against one edge of the clip rectangle
+			static int clipEdge(const Vertex* input, int count, Vertex* output, int axis, float bound, float sign);
+
 		public:
 
 			Buffer();
@@ -40,11 +52,14 @@ namespace plgl {
 			/// Draw this buffer using currently enabled pipeline
 			void draw();
 
-			/// Add vertex to the buffer
-			void vertex(float x, float y, float u, float v, uint8_t r, uint8_t g, uint8_t b, uint8_t a = 255);
+			/// Add vertex to the buffer, 'w' selects the layer of array textures
+			void vertex(float x, float y, float z, float u, float v, float w, uint8_t r, uint8_t g, uint8_t b, uint8_t a = 255);
 
 			/// Add vertex to the buffer
-			void vertex(float x, float y, uint8_t r, uint8_t g, uint8_t b, uint8_t a = 255);
+			void vertex(float x, float y, float z, uint8_t r, uint8_t g, uint8_t b, uint8_t a = 255);
+
+			/// Clip the last triangle against the given rectangle (in NDC), does nothing if it is not yet complete
+			void clip(const ClipRect& rect);
 
 	};
 
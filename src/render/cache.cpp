@@ -0,0 +1,210 @@
+
+#include "cache.hpp"
+#include "util.hpp"
+#include "ops.hpp"
+
+namespace plgl {
+
+	// 'PLGT' in little endian
+	static constexpr uint32_t texture_magic = 0x54474c50;
+	static constexpr uint32_t texture_version = 1;
+
+	static int levelSize(int size, int level) {
+		return std::max(1, size >> level);
+	}
+
+	static int levelCount(int width, int height) {
+		int levels = 1;
+
+		while (levelSize(width, levels - 1) > 1 || levelSize(height, levels - 1) > 1) {
+			levels ++;
+		}
+
+		return levels;
+	}
+
+	/*
+	 * TextureFile
+	 */
+
+	void TextureFile::setup(const uint8_t* pixels, int width, int height, int channels, int levels) {
+		views.clear();
+
+		for (int i = 0; i < levels; i ++) {
+			const int w = levelSize(width, i);
+			const int h = levelSize(height, i);
+
+			views.emplace_back(pixels, w, h, channels);
+			pixels += (size_t) w * h * channels;
+		}
+	}
+
+	bool TextureFile::open(const std::string& path, uint64_t source) {
+		if (!file.open(path)) {
+			return false;
+		}
+
+		Header header;
+
+		if (file.size() < sizeof(Header)) {
+			file.close();
+			return false;
+		}
+
+		memcpy(&header, file.data(), sizeof(Header));
+
+		bool valid = header.magic == texture_magic
+			&& header.version == texture_version
+			&& (source == 0 || header.source == source)
+			&& header.channels >= 1 && header.channels <= 4
+			&& header.levels >= 1 && header.levels <= 32;
+
+		// make sure all the levels are actually there, the file could have been truncated
+		size_t length = sizeof(Header);
+
+		for (uint32_t i = 0; valid && i < header.levels; i ++) {
+			length += (size_t) levelSize(header.width, i) * levelSize(header.height, i) * header.channels;
+		}
+
+		if (!valid || file.size() < length) {
+			file.close();
+			return false;
+		}
+
+		memory.clear();
+		setup(file.data() + sizeof(Header), header.width, header.height, header.channels, header.levels);
+		return true;
+	}
+
+	bool TextureFile::write(const std::string& path, const ImageView& image, bool mipmaps, uint64_t source) {
+		const int width = image.width();
+		const int height = image.height();
+		const int channels = image.channels();
+
+		const int levels = mipmaps ? levelCount(width, height) : 1;
+
+		Header header {texture_magic, texture_version, (uint32_t) width, (uint32_t) height, (uint32_t) channels, (uint32_t) levels, source};
+
+		// many threads can be writing the same file at once, each uses its own temporary
+		const std::string temporary = path + "." + std::to_string(std::hash<std::thread::id> {}(std::this_thread::get_id())) + ".tmp";
+		std::ofstream output {temporary, std::ios::binary | std::ios::trunc};
+		output.write((const char*) &header, sizeof(header));
+
+		for (size_t y = 0; y < image.height(); y ++) {
+			output.write((const char*) image.row(y), width * channels);
+		}
+
+		// each level is computed from the previous one, a 2x2 box filter
+		Image previous;
+
+		for (int i = 1; i < levels; i ++) {
+			const ImageView& from = (i == 1) ? image : previous.view();
+
+			Image current = ops::resize(from, levelSize(width, i), levelSize(height, i), ops::BOX);
+			output.write((const char*) current.data(), current.size());
+			previous = std::move(current);
+		}
+
+		output.close();
+
+		std::error_code error;
+
+		if (!output) {
+			std::filesystem::remove(temporary, error);
+			return false;
+		}
+
+		std::filesystem::rename(temporary, path, error);
+		return !error;
+	}
+
+	TextureFile TextureFile::wrap(Image&& image, bool mipmaps) {
+		TextureFile file;
+		const int width = image.width();
+		const int height = image.height();
+		const int levels = mipmaps ? levelCount(width, height) : 1;
+
+		file.memory.push_back(std::move(image));
+		file.views.push_back(file.memory.back().view());
+
+		for (int i = 1; i < levels; i ++) {
+			file.memory.push_back(ops::resize(file.views.back(), levelSize(width, i), levelSize(height, i), ops::BOX));
+			file.views.push_back(file.memory.back().view());
+		}
+
+		return file;
+	}
+
+	void TextureFile::prefetch() const {
+		file.prefetch();
+	}
+
+	const ImageView& TextureFile::level(int level) const {
+		return views.at(level);
+	}
+
+	int TextureFile::levels() const {
+		return views.size();
+	}
+
+	/*
+	 * TextureCache
+	 */
+
+	std::string impl::TextureCache::directory = "";
+	bool impl::TextureCache::mipmaps = false;
+
+	void impl::TextureCache::enable(const std::string& directory, bool mipmaps) {
+		TextureCache::directory = directory;
+		TextureCache::mipmaps = mipmaps;
+	}
+
+	TextureFile impl::TextureCache::load(const std::string& path, bool mipmaps) {
+		mipmaps = mipmaps || TextureCache::mipmaps;
+
+		TextureFile file;
+
+		if (std::filesystem::path {path}.extension() == TextureFile::extension) {
+			if (!file.open(path)) {
+				fault("Unable to load texture: '{}'!", path);
+			}
+
+			return file;
+		}
+
+		if (directory.empty()) {
+			return TextureFile::wrap(Image::load(path), mipmaps);
+		}
+
+		// cached files are replaced when the source image changes
+		std::error_code error;
+		const auto size = std::filesystem::file_size(path, error);
+		const auto time = std::filesystem::last_write_time(path, error).time_since_epoch().count();
+
+		if (error) {
+			fault("Unable to load texture: '{}'!", path);
+		}
+
+		uint64_t source = impl::hash(&size, sizeof(size), impl::hash(&time, sizeof(time), mipmaps ? 1 : 2));
+
+		char name[32];
+		snprintf(name, sizeof(name), "%016llx%s", (unsigned long long) impl::hash(path), TextureFile::extension);
+		const std::string cached = (std::filesystem::path {directory} / name).string();
+
+		if (file.open(cached, source)) {
+			return file;
+		}
+
+		Image image = Image::load(path);
+
+		// cache is only an optimization, ignore all IO errors
+		std::filesystem::create_directories(directory, error);
+
+		if (TextureFile::write(cached, image, mipmaps, source) && file.open(cached, source)) {
+			return file;
+		}
+
+		return TextureFile::wrap(std::move(image), mipmaps);
+	}
+
+}
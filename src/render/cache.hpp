@@ -0,0 +1,106 @@
+#pragma once
+
+#include "external.hpp"
+#include "image.hpp"
+#include "mapping.hpp"
+
+namespace plgl {
+
+	/**
+	 * @brief Pre-decoded texture.
+	 *
+	 * Pixels stored in the exact layout they are uploaded in, optionally together with
+	 * the whole mip chain, so no decoding is needed before the upload. Files are memory
+	 * mapped and the levels point directly into the mapping. The file consists of a small header
+	 * followed by the tightly packed rows of each level, largest first, in native byte order.
+	 */
+	class TextureFile {
+
+		private:
+
+			struct Header {
+				uint32_t magic;
+				uint32_t version;
+				uint32_t width;
+				uint32_t height;
+				uint32_t channels;
+				uint32_t levels;
+				uint64_t source;
+			};
+
+			impl::MappedFile file;
+			std::vector<Image> memory;
+			std::vector<ImageView> views;
+
+			void setup(const uint8_t* pixels, int width, int height, int channels, int levels);
+
+		public:
+
+			/// File name extension used by texture files
+			static constexpr const char* extension = ".plt";
+
+			/**
+			 * @brief Map texture file.
+			 *
+			 * Returns false if the file doesn't exist, is damaged, or was written
+			 * for a different source (see write()), a non-zero source must match exactly.
+			 */
+			bool open(const std::string& path, uint64_t source = 0);
+
+			/**
+			 * @brief Write texture file.
+			 *
+			 * The file is first written under a temporary name and only then
+			 * renamed, so readers never see a partial file, returns false on IO errors.
+			 *
+			 * @param[in] path    Path of the output file
+			 * @param[in] image   Image to store
+			 * @param[in] mipmaps Also store all mip levels, down to 1x1
+			 * @param[in] source  Value identifying the origin of the image, checked by open()
+			 */
+			static bool write(const std::string& path, const ImageView& image, bool mipmaps = false, uint64_t source = 0);
+
+			/// Wrap an already decoded image, so it can be used in place of a mapped file, the mip levels are computed in memory
+			static TextureFile wrap(Image&& image, bool mipmaps = false);
+
+			/// Start reading the file in the background
+			void prefetch() const;
+
+			/// returns the given mip level, 0 being the full size image
+			const ImageView& level(int level) const;
+
+			/// returns the number of stored mip levels
+			int levels() const;
+
+	};
+
+	namespace impl {
+
+		/**
+		 * Directory of texture files created from the images loaded by the application,
+		 * see plgl::texture_cache()
+		 */
+		class TextureCache {
+
+			private:
+
+				static std::string directory;
+				static bool mipmaps;
+
+			public:
+
+				/// Set the cache directory, an empty string disables the cache
+				static void enable(const std::string& directory, bool mipmaps);
+
+				/**
+				 * Load texture from the given image file, through the cache if it is enabled, texture files
+				 * (with the TextureFile::extension) are always mapped directly. Mip levels are included if they were
+				 * enabled for the cache or if 'mipmaps' is set. Safe to call from any thread.
+				 */
+				static TextureFile load(const std::string& path, bool mipmaps = false);
+
+		};
+
+	}
+
+}
@@ -0,0 +1,125 @@
+
+#include "canvas.hpp"
+#include "state.hpp"
+
+namespace plgl {
+
+	/*
+	 * Canvas
+	 */
+
+	Canvas::Canvas(int width, int height) {
+		this->buffer = Image::allocate(width, height, 4);
+		this->buffer.clear({0, 0, 0, 0});
+		this->c = 4;
+		this->w = width;
+		this->h = height;
+
+		impl::GLState::bindTexture(GL_TEXTURE_2D, tid);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+
+		if (GLAD_GL_VERSION_4_2 || GLAD_GL_ARB_texture_storage) {
+			glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, width, height);
+		} else {
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+		}
+
+		glGenBuffers(2, pbos);
+
+		for (GLuint pbo : pbos) {
+			impl::GLState::bindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo);
+			glBufferData(GL_PIXEL_UNPACK_BUFFER, buffer.size(), nullptr, GL_STREAM_DRAW);
+		}
+
+		impl::GLState::bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		invalidate();
+	}
+
+	void Canvas::close() {
+		for (GLuint& pbo : pbos) {
+			if (pbo) {
+				impl::GLState::deleteBuffer(pbo);
+				pbo = 0;
+			}
+		}
+
+		buffer.close();
+		Texture::close();
+	}
+
+	Pixel Canvas::pixel(int x, int y) {
+		invalidate(y, 1);
+		return buffer.pixel(x, y);
+	}
+
+	uint8_t* Canvas::row(int y) {
+		invalidate(y, 1);
+		return buffer.pixel(0, y).data();
+	}
+
+	Image& Canvas::image() {
+		invalidate();
+		return buffer;
+	}
+
+	void Canvas::invalidate() {
+		invalidate(0, h);
+	}
+
+	void Canvas::invalidate(int y, int h) {
+		const int end = std::min(y + h, this->h);
+		y = std::max(y, 0);
+
+		if (y >= end) {
+			return;
+		}
+
+		if (first >= last) {
+			first = y;
+			last = end;
+			return;
+		}
+
+		first = std::min(first, y);
+		last = std::max(last, end);
+	}
+
+	void Canvas::update() {
+		if (first >= last || !tid) {
+			return;
+		}
+
+		const size_t stride = w * 4;
+		const size_t length = (last - first) * stride;
+
+		// alternate between the buffers, the other one can still be in use by the GPU
+		impl::GLState::bindBuffer(GL_PIXEL_UNPACK_BUFFER, pbos[next]);
+		next ^= 1;
+
+		void* mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, length, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+
+		if (mapped) {
+			memcpy(mapped, buffer.pixel(0, first).data(), length);
+			glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+		}
+
+		impl::GLState::bindTexture(GL_TEXTURE_2D, tid);
+
+		// with a bound unpack buffer the pointer is an offset into that buffer
+		if (mapped) {
+			glTexSubImage2D(GL_TEXTURE_2D, 0, 0, first, w, last - first, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+			impl::GLState::bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		} else {
+			impl::GLState::bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+			glTexSubImage2D(GL_TEXTURE_2D, 0, 0, first, w, last - first, GL_RGBA, GL_UNSIGNED_BYTE, buffer.pixel(0, first).data());
+		}
+
+		first = last = 0;
+	}
+
+	void Canvas::use() {
+		update();
+		Texture::use();
+	}
+
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "external.hpp"
+#include "texture.hpp"
+
+namespace plgl {
+
+	/**
+	 * @brief Texture with a persistent CPU copy of its pixels.
+	 *
+	 * The texture storage is allocated once and never changes size, modified rows are streamed
+	 * into it when the canvas is drawn, through two pixel unpack buffers used in turns, so that
+	 * writing the next frame doesn't have to wait for the GPU to finish reading the last one.
+	 * Writes through pixel() and row() only mark the affected rows, image() marks the whole canvas.
+	 */
+	class Canvas : public Texture {
+
+		private:
+
+			Image buffer;
+			GLuint pbos[2] = {0, 0};
+			int next = 0;
+
+			// range of rows modified since the last update, [first, last)
+			int first = 0;
+			int last = 0;
+
+		public:
+
+			Canvas(int width, int height);
+			void close();
+
+			/// Get writable pointer to the given pixel, marks its row as modified
+			Pixel pixel(int x, int y);
+
+			/// Get writable pointer to the start of the given row, marks it as modified
+			uint8_t* row(int y);
+
+			/// Get the whole pixel buffer, marks all rows as modified
+			Image& image();
+
+			/// Mark all rows as modified
+			void invalidate();
+
+			/// Mark the given range of rows as modified
+			void invalidate(int y, int h);
+
+			/// Copy all modified rows into the texture, done automatically by use()
+			void update();
+
+			void use() override;
+
+	};
+
+}
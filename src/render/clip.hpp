@@ -0,0 +1,14 @@
+#pragma once
+
+namespace plgl {
+
+	enum ClipMode {
+
+		/// clip geometry on the CPU, doesn't break batches
+		CLIP_GEOMETRY,
+
+		/// use the scissor test, every clip change causes a flush
+		CLIP_SCISSOR
+	};
+
+}
@@ -0,0 +1,117 @@
+
+#include "document.hpp"
+#include "renderer.hpp"
+#include "globals.hpp"
+
+namespace plgl {
+
+	/*
+	 * TextDocument
+	 */
+
+	TextDocument::TextDocument(Font& font, float size, float spacing)
+	: font(&font), size(size) {
+		style.spacing = spacing;
+		starts.push_back(0);
+	}
+
+	void TextDocument::append(std::string_view text) {
+		const size_t base = data.size();
+		data.append(text);
+
+		// the last line may have grown, its layout will be redone
+		visible.erase(starts.size() - 1);
+
+		const char* begin = data.data() + base;
+		const char* end = data.data() + data.size();
+
+		while (const char* found = (const char*) memchr(begin, '\n', end - begin)) {
+			starts.push_back(found - data.data() + 1);
+			begin = found + 1;
+		}
+	}
+
+	void TextDocument::clear() {
+		data.clear();
+		starts.assign(1, 0);
+		visible.clear();
+		offset = 0;
+	}
+
+	size_t TextDocument::lines() const {
+		return starts.size();
+	}
+
+	std::string_view TextDocument::line(size_t index) const {
+		const size_t begin = starts[index];
+		size_t end = (index + 1 < starts.size()) ? starts[index + 1] - 1 : data.size();
+
+		// text copied from windows uses CRLF line breaks
+		if (end > begin && data[end - 1] == '\r') {
+			end --;
+		}
+
+		return std::string_view {data}.substr(begin, end - begin);
+	}
+
+	float TextDocument::height() const {
+		return lines() * leading();
+	}
+
+	float TextDocument::leading() const {
+		return size * style.spacing;
+	}
+
+	void TextDocument::scroll(float offset) {
+		this->offset = std::max(0.0f, offset);
+		this->follow = false;
+	}
+
+	float TextDocument::scroll() const {
+		return offset;
+	}
+
+	void TextDocument::tail(bool enable) {
+		this->follow = enable;
+	}
+
+	void TextDocument::draw(float x, float y, float w, float h) {
+		if (w <= 0 || h <= 0) {
+			return;
+		}
+
+		const float lead = leading();
+
+		if (follow) {
+			offset = std::max(0.0f, height() - h);
+		}
+
+		// only the lines that overlap the box, screen Y axis points down so lines go down from 'y'
+		const size_t first = std::min(lines(), (size_t) std::floor(offset / lead));
+		const size_t last = std::min(lines(), (size_t) std::ceil((offset + h) / lead));
+
+		// layouts of lines that are still visible are kept, the rest is dropped
+		ankerl::unordered_dense::map<size_t, TextLayout> current;
+		current.reserve(last - first);
+
+		renderer->clip_push(x, y, x + w, y + h);
+
+		for (size_t index = first; index < last; index ++) {
+			auto it = visible.find(index);
+
+			if (it != visible.end()) {
+				it = current.emplace(index, std::move(it->second)).first;
+			} else {
+				it = current.emplace(index, TextLayout {*font, size, std::string {line(index)}, style}).first;
+			}
+
+			// baseline sits one text size below the top of the line
+			const float top = y + index * lead - offset;
+			renderer->text(x, top + size, it->second);
+		}
+
+		renderer->clip_pop();
+		visible.swap(current);
+	}
+
+}
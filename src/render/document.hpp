@@ -0,0 +1,72 @@
+#pragma once
+
+#include "external.hpp"
+#include "layout.hpp"
+
+namespace plgl {
+
+	/**
+	 * @brief Large block of text, drawn one visible line at a time.
+	 *
+	 * Keeps the offset of each line, the index is extended as text is appended, so
+	 * tailing a growing log only scans the new data. Only the lines inside the drawn box are
+	 * laid out, and their layouts are kept while they stay visible, so scrolling only lays out the lines
+	 * that just came into view. Lines are never wrapped, a long line is cut off at the edge of the box.
+	 *
+	 * @see plgl::text(TextDocument&, float, float, float, float)
+	 */
+	class TextDocument {
+
+		private:
+
+			Font* font;
+			float size;
+			TextStyle style;
+
+			std::string data;
+
+			// offset of the first byte of each line
+			std::vector<size_t> starts;
+
+			// layouts of the lines drawn in the last frame, keyed by line index
+			ankerl::unordered_dense::map<size_t, TextLayout> visible;
+
+			// distance from the top of the document to the top of the box
+			float offset = 0;
+			bool follow = false;
+
+		public:
+
+			TextDocument(Font& font, float size, float spacing = 1.25f);
+
+			/// Add text to the end of the document, only the new data is scanned for line breaks
+			void append(std::string_view text);
+
+			/// Remove all text
+			void clear();
+
+			/// Number of lines, the last one is the (possibly empty) unterminated line
+			size_t lines() const;
+
+			/// Get the text of the given line, without the line break
+			std::string_view line(size_t index) const;
+
+			/// Total height of all lines
+			float height() const;
+
+			/// Distance between the baselines of two lines
+			float leading() const;
+
+			/// Scroll so that the top of the box is at the given distance from the start of the document
+			void scroll(float offset);
+			float scroll() const;
+
+			/// Keep the last line in view as text is appended
+			void tail(bool enable);
+
+			/// Draw the visible lines into the box that has its top left corner at (x, y)
+			void draw(float x, float y, float w, float h);
+
+	};
+
+}
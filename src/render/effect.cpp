@@ -0,0 +1,80 @@
+
+#include "effect.hpp"
+#include "pipeline.hpp"
+#include "renderer.hpp"
+#include "globals.hpp"
+
+namespace plgl {
+
+	/*
+	 * Effect
+	 */
+
+	void Effect::store(const char* name, int count, float x, float y, float z, float w) {
+		for (Uniform& uniform : uniforms) {
+			if (uniform.name == name) {
+				uniform.count = count;
+				uniform.values[0] = x;
+				uniform.values[1] = y;
+				uniform.values[2] = z;
+				uniform.values[3] = w;
+				return;
+			}
+		}
+
+		uniforms.push_back({name, count, {x, y, z, w}});
+	}
+
+	Effect::Effect(const std::string& source)
+	: source(source) {}
+
+	Effect::~Effect() {
+
+		// the renderer must not keep pipelines that use our shaders
+		if (renderer) {
+			renderer->releaseEffect(this);
+		}
+	}
+
+	Shader& Effect::getShader(Target target) {
+		std::unique_ptr<Shader>& shader = shaders[target];
+
+		if (!shader) {
+			shader = Pipeline::createEffectShader(target, source);
+		}
+
+		return *shader;
+	}
+
+	void Effect::apply(Shader& shader) {
+		for (Uniform& uniform : uniforms) {
+			int location = shader.uniform(uniform.name.c_str());
+
+			if (location == -1) {
+				continue;
+			}
+
+			if (uniform.count == 1) glUniform1fv(location, 1, uniform.values);
+			if (uniform.count == 2) glUniform2fv(location, 1, uniform.values);
+			if (uniform.count == 3) glUniform3fv(location, 1, uniform.values);
+			if (uniform.count == 4) glUniform4fv(location, 1, uniform.values);
+		}
+	}
+
+	void Effect::set(const char* name, float x) {
+		store(name, 1, x, 0, 0, 0);
+	}
+
+	void Effect::set(const char* name, float x, float y) {
+		store(name, 2, x, y, 0, 0);
+	}
+
+	void Effect::set(const char* name, float x, float y, float z) {
+		store(name, 3, x, y, z, 0);
+	}
+
+	void Effect::set(const char* name, float x, float y, float z, float w) {
+		store(name, 4, x, y, z, w);
+	}
+
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "shader.hpp"
+
+namespace plgl {
+
+	/**
+	 * @brief User defined fragment shader.
+	 *
+	 * The given GLSL source must define a function with the signature
+	 * `vec4 shade(vec4 color, vec2 uv)`, it is called for every drawn pixel with the
+	 * interpolated vertex color and texture coordinates and returns the final color.
+	 * The source can call `vec4 texel(vec2 uv)` to sample the bound texture,
+	 * and declare any additional uniforms, those can later be set using Effect::set().
+	 *
+	 * Effects used as filters (see plgl::filter()) additionally have access to
+	 * `uResolution` (output size in pixels), `uTexel` (size of one input pixel in UV space) and
+	 * the `uScene` sampler that always contains the unprocessed frame.
+	 *
+	 * @example
+	 * @code{.cpp}
+	 * Effect grayscale {R"(
+	 *     vec4 shade(vec4 color, vec2 uv) {
+	 *         vec4 pixel = texel(uv) * color;
+	 *         float value = dot(pixel.rgb, vec3(0.299, 0.587, 0.114));
+	 *         return vec4(vec3(value), pixel.a);
+	 *     }
+	 * )"};
+	 *
+	 * shader(grayscale);
+	 * image(10, 10);
+	 * shader(OFF);
+	 * @endcode
+	 */
+	class Effect {
+
+		public:
+
+			enum Target {
+				SHAPE  = 0,
+				IMAGE  = 1,
+				FILTER = 2,
+				IMAGE_ARRAY = 3
+			};
+
+		private:
+
+			struct Uniform {
+				std::string name;
+				int count;
+				float values[4];
+			};
+
+			std::string source;
+			std::unique_ptr<Shader> shaders[4];
+			std::vector<Uniform> uniforms;
+
+			void store(const char* name, int count, float x, float y, float z, float w);
+
+		public:
+
+			Effect(const std::string& source);
+			~Effect();
+
+			/// Get (and compile if needed) the variant of this effect for the given target
+			Shader& getShader(Target target);
+
+			/// Upload stored uniform values into the given shader variant
+			void apply(Shader& shader);
+
+		public:
+
+			/**
+			 * @brief Set uniform value
+			 *
+			 * Values are stored and uploaded each time a batch using this effect is drawn,
+			 * so changing a value affects everything drawn since the last flush.
+			 */
+			void set(const char* name, float x);
+
+			/// Set uniform vec2 value
+			void set(const char* name, float x, float y);
+
+			/// Set uniform vec3 value
+			void set(const char* name, float x, float y, float z);
+
+			/// Set uniform vec4 value
+			void set(const char* name, float x, float y, float z, float w);
+
+	};
+
+}
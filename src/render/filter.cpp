@@ -0,0 +1,145 @@
+
+#include "filter.hpp"
+#include "globals.hpp"
+#include "state.hpp"
+
+namespace plgl::impl {
+
+	/*
+	 * FilterChain
+	 */
+
+	Framebuffer& FilterChain::acquire(int width, int height, const Framebuffer* input) {
+		for (Framebuffer& target : targets) {
+			if (&target != input && target.width() == width && target.height() == height) {
+				return target;
+			}
+		}
+
+		Framebuffer& target = targets.emplace_back();
+		target.resize(width, height);
+		return target;
+	}
+
+	void FilterChain::draw(Effect& effect, Framebuffer& input, GLuint target, int width, int height) {
+		Shader& shader = effect.getShader(Effect::FILTER);
+
+		GLState::bindFramebuffer(GL_FRAMEBUFFER, target);
+		glViewport(0, 0, width, height);
+
+		input.use();
+		shader.use();
+
+		glUniform1i(shader.uniform("uSampler"), 0);
+		glUniform1i(shader.uniform("uScene"), 1);
+		glUniform2f(shader.uniform("uResolution"), width, height);
+		glUniform2f(shader.uniform("uTexel"), 1.0f / input.width(), 1.0f / input.height());
+		effect.apply(shader);
+
+		glDrawArrays(GL_TRIANGLES, 0, 3);
+	}
+
+	FilterChain::FilterChain()
+	: copy("vec4 shade(vec4 color, vec2 uv) { return texel(uv); }"), scene(4, true) {}
+
+	FilterChain::~FilterChain() {
+		if (vao) {
+			GLState::deleteVertexArray(vao);
+		}
+	}
+
+	void FilterChain::add(Effect& effect, float scale) {
+		passes.push_back({&effect, scale});
+	}
+
+	void FilterChain::clear() {
+		passes.clear();
+	}
+
+	void FilterChain::remove(Effect* effect) {
+		std::erase_if(passes, [effect] (const Pass& pass) {
+			return pass.effect == effect;
+		});
+	}
+
+	void FilterChain::begin() {
+		active = !passes.empty();
+
+		if (active) {
+
+			// window was resized, all old targets are now useless
+			if (scene.width() != plgl::width || scene.height() != plgl::height) {
+				targets.clear();
+			}
+
+			scene.resize(plgl::width, plgl::height);
+			scene.bind();
+		}
+	}
+
+	void FilterChain::end() {
+		if (!active) {
+			return;
+		}
+
+		active = false;
+
+		const int w = plgl::width;
+		const int h = plgl::height;
+
+		resolved.resize(w, h);
+		scene.blit(resolved.framebuffer(), w, h);
+
+		// filters are always drawn as a simple full screen triangle
+		GLint modes[2];
+		glGetIntegerv(GL_POLYGON_MODE, modes);
+		GLboolean depth = glIsEnabled(GL_DEPTH_TEST);
+		glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+		glDisable(GL_BLEND);
+		glDisable(GL_SCISSOR_TEST);
+		glDisable(GL_DEPTH_TEST);
+
+		if (!vao) {
+			glGenVertexArrays(1, &vao);
+		}
+
+		GLState::bindVertexArray(vao);
+
+		// the unprocessed frame is always available as 'uScene'
+		GLState::bindTexture(GL_TEXTURE_2D, resolved.handle(), 1);
+
+		Framebuffer* input = &resolved;
+
+		for (size_t i = 0; i < passes.size(); i ++) {
+			Pass& pass = passes[i];
+
+			int pw = std::max(1, (int) (w * pass.scale));
+			int ph = std::max(1, (int) (h * pass.scale));
+
+			// the last full resolution pass can write directly into the window
+			if (i + 1 == passes.size() && pw == w && ph == h) {
+				draw(*pass.effect, *input, 0, w, h);
+				input = nullptr;
+				break;
+			}
+
+			Framebuffer& output = acquire(pw, ph, input);
+			draw(*pass.effect, *input, output.framebuffer(), pw, ph);
+			input = &output;
+		}
+
+		// the window framebuffer is multisampled, so we can't just blit into it
+		if (input) {
+			draw(copy, *input, 0, w, h);
+		}
+
+		glEnable(GL_BLEND);
+		glEnable(GL_SCISSOR_TEST);
+		glPolygonMode(GL_FRONT_AND_BACK, modes[0]);
+
+		if (depth) {
+			glEnable(GL_DEPTH_TEST);
+		}
+	}
+
+}
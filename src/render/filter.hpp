@@ -0,0 +1,58 @@
+#pragma once
+
+#include "framebuffer.hpp"
+#include "effect.hpp"
+
+namespace plgl::impl {
+
+	/**
+	 * Post-processing chain, when any filter is registered the frame
+	 * is rendered into an offscreen framebuffer and the filters are then applied
+	 * one after another, each reading the output of the previous one.
+	 */
+	class FilterChain {
+
+		private:
+
+			struct Pass {
+				Effect* effect;
+				float scale;
+			};
+
+			bool active = false;
+			GLuint vao = 0;
+			Effect copy;
+
+			std::vector<Pass> passes;
+			Framebuffer scene;
+			Framebuffer resolved;
+
+			// ping-pong targets, there will be at most two per used resolution
+			std::list<Framebuffer> targets;
+
+			Framebuffer& acquire(int width, int height, const Framebuffer* input);
+			void draw(Effect& effect, Framebuffer& input, GLuint target, int width, int height);
+
+		public:
+
+			FilterChain();
+			~FilterChain();
+
+			/// Append a filter pass, rendered at the given fraction of the window resolution
+			void add(Effect& effect, float scale);
+
+			/// Remove all filter passes
+			void clear();
+
+			/// Remove all passes using the given effect
+			void remove(Effect* effect);
+
+			/// Redirect rendering into the offscreen framebuffer if there are any filters
+			void begin();
+
+			/// Apply all filters and present the result to the window
+			void end();
+
+	};
+
+}
@@ -1,6 +1,9 @@
 
 #include "font.hpp"
 #include "atlas.hpp"
+#include "pool.hpp"
+#include "utf8.hpp"
+#include "mapping.hpp"
 
 #include "msdfgen.h"
 #include "msdfgen-ext.h"
@@ -12,6 +15,29 @@ namespace plgl {
 
 	static msdfgen::FreetypeHandle* freetype = msdfgen::initializeFreetype();
 
+	// parameters used for all generated glyphs, part of the glyph cache key
+	static constexpr float glyph_scale = 64;
+	static constexpr float glyph_range = 6;
+
+	static constexpr uint32_t glyphs_magic = 0x46474c50;
+	static constexpr uint32_t glyphs_version = 2;
+
+	// layout of the glyph cache files, the header is followed by
+	// the glyph table and then the images of all non-empty glyphs
+	struct GlyphsHeader {
+		uint32_t magic;
+		uint32_t version;
+		uint64_t key;
+		uint32_t count;
+		uint32_t resolution;
+	};
+
+	struct GlyphsRecord {
+		int32_t unicode;
+		int32_t empty;
+		float xoff, yoff, advance;
+	};
+
 	/*
 	 * Font
 	 */
@@ -21,70 +47,340 @@ namespace plgl {
 		return *reinterpret_cast<FT_Face*>(font);
 	}
 
-	bool Font::loadUnicode(msdfgen::FontHandle* font, uint32_t unicode, float scale, float range, const std::function<void()>& on_resize) {
+	/// Generate the MSDF image of a glyph, safe to call from any thread
+	static Image renderGlyph(msdfgen::Shape& shape, double scale, double range, double tx, double ty) {
+		edgeColoringSimple(shape, 3.0);
+
+		Image image = Image::allocate(Font::resolution, Font::resolution, 4);
+		msdfgen::Bitmap<float, 3> msdf(image.width(), image.height());
+
+		msdfgen::SDFTransformation transform {
+			msdfgen::Projection(scale, msdfgen::Vector2(tx, ty)),
+			msdfgen::Range(range) / scale
+		};
+
+		msdfgen::generateMSDF(msdf, shape, transform);
+
+		// convert to some normal format...
+		for (int x = 0; x < msdf.width(); x++) {
+			for (int y = 0; y < msdf.height(); y++) {
+				float* pixel = msdf(x, y);
+
+				uint8_t r = msdfgen::pixelFloatToByte(pixel[0]);
+				uint8_t g = msdfgen::pixelFloatToByte(pixel[1]);
+				uint8_t b = msdfgen::pixelFloatToByte(pixel[2]);
+				uint8_t a = msdfgen::pixelFloatToByte(pixel[3]);
+
+				image.pixel(x, y).set(r, g, b, a);
+			}
+		}
+
+		return image;
+	}
+
+	void Font::loadUnicode(uint32_t unicode, float scale, float range, const std::function<void()>& on_resize) {
 		msdfgen::Shape shape;
-		GlyphInfo info;
+		GlyphInfo& info = insertGlyph(unicode);
+		double advance = 0;
+
+		// glyphs missing from the font are remembered as empty, so that we don't look for them again
+		if (!loadGlyph(shape, font, unicode, msdfgen::FONT_SCALING_EM_NORMALIZED, &advance)) {
+			info = {};
+			info.ready = true;
+			return;
+		}
+
+		// FreeType is not thread safe, so the outline is read here, and only the expensive part is done in the background
+		shape.normalize();
+
+		info = {};
+		info.advance = advance * scale;
+		auto box = shape.getBounds();
+
+		float tx = (1 - (box.r - box.l)) * 0.5f - box.l;
+		float ty = (1 - (box.t - box.b)) * 0.5f - box.b;
+
+		info.xoff = (-tx) * scale;
+		info.yoff = ty * scale;
+		info.ready = false;
+
+		if (!async) {
+			Image image = renderGlyph(shape, scale, range, tx, ty);
+			place(unicode, image, on_resize);
+			return;
+		}
+
+		queue->outstanding ++;
 
-		if (loadGlyph(shape, font, unicode, msdfgen::FONT_SCALING_EM_NORMALIZED, &info.advance)) {
-			shape.normalize();
+		impl::ThreadPool::get().submit([queue = this->queue, unicode, shape, scale, range, tx, ty] () mutable {
+			Image image = renderGlyph(shape, scale, range, tx, ty);
 
-			info.advance *= scale;
-			auto box = shape.getBounds();
+			{
+				std::lock_guard lock {queue->mutex};
+				queue->finished.push_back({(int) unicode, std::move(image)});
+				queue->outstanding --;
+				queue->ready = true;
+			}
 
-			float tx = (1 - (box.r - box.l)) * 0.5f - box.l;
-			float ty = (1 - (box.t - box.b)) * 0.5f - box.b;
+			queue->condition.notify_all();
+		});
+	}
 
-			info.xoff = (-tx) * scale;
-			info.yoff = ty * scale;
+	GlyphInfo* Font::findGlyph(int unicode) {
+		if ((unsigned) unicode < latin) {
+			return latin_loaded[unicode] ? &latin_glyphs[unicode] : nullptr;
+		}
+
+		auto it = cdata.find(unicode);
+		return it == cdata.end() ? nullptr : &it->second;
+	}
 
-			edgeColoringSimple(shape, 3.0);
+	GlyphInfo& Font::insertGlyph(int unicode) {
+		if ((unsigned) unicode < latin) {
+			latin_loaded.set(unicode);
+			return latin_glyphs[unicode];
+		}
 
-			Image image = Image::allocate(resolution, resolution, 4);
-			msdfgen::Bitmap<float, 3> msdf(image.width(), image.height());
+		return cdata[unicode];
+	}
 
-			msdfgen::SDFTransformation transform {
-				msdfgen::Projection(scale, msdfgen::Vector2(tx, ty)),
-				msdfgen::Range(range) / scale
-			};
+	void Font::eraseGlyph(int unicode) {
+		if ((unsigned) unicode < latin) {
+			latin_loaded.reset(unicode);
+			return;
+		}
 
-			msdfgen::generateMSDF(msdf, shape, transform);
+		cdata.erase(unicode);
+	}
 
-			// convert to some normal format...
-			for (int x = 0; x < msdf.width(); x++) {
-				for (int y = 0; y < msdf.height(); y++) {
-					float* pixel = msdf(x, y);
+	size_t Font::glyphs() const {
+		return latin_loaded.count() + cdata.size();
+	}
 
-					uint8_t r = msdfgen::pixelFloatToByte(pixel[0]);
-					uint8_t g = msdfgen::pixelFloatToByte(pixel[1]);
-					uint8_t b = msdfgen::pixelFloatToByte(pixel[2]);
-					uint8_t a = msdfgen::pixelFloatToByte(pixel[3]);
+	float Font::getKerning(int prev, int unicode) {
+		auto query = [this] (int prev, int unicode) {
+			double kerning = 0;
+			msdfgen::getKerning(kerning, font, prev, unicode, msdfgen::FONT_SCALING_EM_NORMALIZED);
+			return (float) kerning;
+		};
 
-					image.pixel(x, y).set(r, g, b, a);
-				}
+		// all latin pairs fit in a 256x256 table, NaN marks pairs that were not queried yet
+		if ((unsigned) prev < latin && (unsigned) unicode < latin) {
+			if (latin_kerning.empty()) {
+				latin_kerning.resize(latin * latin, std::numeric_limits<float>::quiet_NaN());
 			}
 
-			Sprite sprite = atlas.submit(image, on_resize);
-			image.close();
+			float& kerning = latin_kerning[prev * latin + unicode];
 
-			info.x0 = sprite.x;
-			info.y0 = sprite.y + sprite.h;
-			info.x1 = sprite.x + sprite.w;
-			info.y1 = sprite.y;
+			if (std::isnan(kerning)) {
+				kerning = query(prev, unicode);
+			}
 
-			cdata[unicode] = info;
+			return kerning;
+		}
 
-			// update texture
-			atlas.upload();
+		const uint64_t pair = ((uint64_t) (uint32_t) prev << 32) | (uint32_t) unicode;
+		auto it = kerning_pairs.find(pair);
 
-			return true;
+		if (it != kerning_pairs.end()) {
+			return it->second;
 		}
 
-		return false;
+		return kerning_pairs[pair] = query(prev, unicode);
 	}
 
-	Font::Font(const char* path, int weight) {
+	void Font::collect(const std::function<void()>& on_resize) {
+		if (!queue->ready) {
+			return;
+		}
+
+		std::vector<Baked> finished;
+
+		{
+			std::lock_guard lock {queue->mutex};
+			finished.swap(queue->finished);
+			queue->ready = false;
+		}
+
+		for (Baked& baked : finished) {
+			place(baked.unicode, baked.image, on_resize);
+		}
+	}
+
+	void Font::place(uint32_t unicode, const ImageView& image, const std::function<void()>& on_resize) {
+		Sprite sprite = atlas->submit(image, on_resize);
+		GlyphInfo& info = insertGlyph(unicode);
+
+		info.x0 = sprite.x;
+		info.y0 = sprite.y + sprite.h;
+		info.x1 = sprite.x + sprite.w;
+		info.y1 = sprite.y;
+		info.layer = sprite.layer;
+		info.ready = true;
+	}
+
+	std::string Font::cache_directory = "";
+	std::shared_ptr<Atlas> Font::shared_atlas;
+
+	void Font::setup(const uint8_t* data, size_t size, int weight) {
+		msdfgen::setFontVariationAxis(freetype, font, "Weight", weight);
+
+		if (!cache_directory.empty()) {
+			key = impl::hash(data, size, impl::hash(&weight, sizeof(weight), glyphs_version));
+			key = impl::hash(&glyph_range, sizeof(glyph_range), impl::hash(&glyph_scale, sizeof(glyph_scale), key));
+			key = impl::hash(&resolution, sizeof(resolution), key);
+
+			load_glyphs();
+		}
+	}
+
+	std::string Font::path() const {
+		char name[32];
+		snprintf(name, sizeof(name), "%016llx.msdf", (unsigned long long) key);
+		return (std::filesystem::path {cache_directory} / name).string();
+	}
+
+	void Font::load_glyphs() {
+		impl::MappedFile file;
+
+		if (!file.open(path()) || file.size() < sizeof(GlyphsHeader)) {
+			return;
+		}
+
+		GlyphsHeader header;
+		memcpy(&header, file.data(), sizeof(header));
+
+		if (header.magic != glyphs_magic || header.version != glyphs_version || header.key != key || header.resolution != resolution) {
+			return;
+		}
+
+		const size_t bytes = resolution * resolution * 4;
+		const uint8_t* table = file.data() + sizeof(GlyphsHeader);
+		const uint8_t* images = table + header.count * sizeof(GlyphsRecord);
+		const uint8_t* end = file.data() + file.size();
+
+		if (images > end) {
+			return;
+		}
+
+		// glyphs are copied straight out of the mapping into the atlas
+		for (uint32_t i = 0; i < header.count; i ++) {
+			GlyphsRecord record;
+			memcpy(&record, table + i * sizeof(GlyphsRecord), sizeof(record));
+
+			GlyphInfo& info = insertGlyph(record.unicode);
+			info = {};
+			info.xoff = record.xoff;
+			info.yoff = record.yoff;
+			info.advance = record.advance;
+			info.ready = true;
+
+			if (record.empty) {
+				continue;
+			}
+
+			if (images + bytes > end) {
+				eraseGlyph(record.unicode);
+				break;
+			}
+
+			place(record.unicode, ImageView {images, resolution, resolution, 4}, {});
+			images += bytes;
+		}
+
+		saved = glyphs();
+	}
+
+	void Font::save_glyphs() {
+		std::vector<GlyphsRecord> records;
+		std::vector<ImageView> images;
+
+		auto append = [&] (int unicode, const GlyphInfo& info) {
+
+			// glyphs still being generated are left for the next run
+			if (!info.ready) {
+				return;
+			}
+
+			const int w = info.x1 - info.x0;
+			const int h = info.y0 - info.y1;
+
+			records.push_back({unicode, w == 0, info.xoff, info.yoff, info.advance});
+
+			if (w != 0) {
+				images.push_back(atlas->getImage(info.layer).view(info.x0, info.y1, w, h));
+			}
+		};
 
+		for (int unicode = 0; unicode < latin; unicode ++) {
+			if (latin_loaded[unicode]) append(unicode, latin_glyphs[unicode]);
+		}
+
+		for (auto& [unicode, info] : cdata) {
+			append(unicode, info);
+		}
+
+		GlyphsHeader header {glyphs_magic, glyphs_version, key, (uint32_t) records.size(), resolution};
+
+		// cache is only an optimization, ignore all IO errors
+		std::error_code error;
+		std::filesystem::create_directories(cache_directory, error);
+
+		const std::string target = path();
+		const std::string temporary = target + ".tmp";
+
+		std::ofstream file {temporary, std::ios::binary | std::ios::trunc};
+		file.write((const char*) &header, sizeof(header));
+		file.write((const char*) records.data(), records.size() * sizeof(GlyphsRecord));
+
+		for (const ImageView& image : images) {
+			for (size_t y = 0; y < image.height(); y ++) {
+				file.write((const char*) image.row(y), image.width() * image.channels());
+			}
+		}
+
+		file.close();
+
+		if (file) {
+			std::filesystem::rename(temporary, target, error);
+			saved = records.size();
+		} else {
+			std::filesystem::remove(temporary, error);
+		}
+	}
+
+	void Font::cache(const std::string& path) {
+		cache_directory = path;
+	}
+
+	std::atomic_uint32_t Font::counter = 0;
+
+	Font::Font()
+	: id(++ counter), atlas(shared_atlas ? shared_atlas : std::make_shared<Atlas>()), queue(std::make_shared<Queue>()) {
 		this->base = 100;
+	}
+
+	Font::~Font() {
+
+		// moved-from fonts have no atlas left to save glyphs from
+		if (atlas && key != 0 && glyphs() > saved) {
+			save_glyphs();
+		}
+	}
+
+	void Font::open(std::vector<uint8_t>&& bytes, const std::string& name, int weight) {
+		this->bytes = std::move(bytes);
+		this->font = loadFontData(freetype, reinterpret_cast<const msdfgen::byte*>(this->bytes.data()), this->bytes.size());
+
+		if (!font) {
+			fault("Failed to open font: '{}'", name);
+		}
+
+		setup(this->bytes.data(), this->bytes.size(), weight);
+	}
+
+	Font::Font(const char* path, int weight)
+	: Font() {
 
 		if (!freetype) {
 			fault("Failed to initialize FreeType library!");
@@ -93,62 +389,126 @@ namespace plgl {
 		if (std::strcmp(path, "default") == 0) {
 			const auto* bytes = reinterpret_cast<const msdfgen::byte*>(default_font_ttf);
 			this->font = loadFontData(freetype, bytes, sizeof(default_font_ttf));
+
+			if (font) {
+				setup(bytes, sizeof(default_font_ttf), weight);
+			}
 		} else {
-			this->font = loadFont(freetype, path);
+
+			// the whole file is needed anyway, to identify the face in the glyph cache
+			std::ifstream file {path, std::ios::binary};
+
+			if (file) {
+				bytes.assign(std::istreambuf_iterator<char> {file}, std::istreambuf_iterator<char> {});
+				this->font = loadFontData(freetype, reinterpret_cast<const msdfgen::byte*>(bytes.data()), bytes.size());
+			}
+
+			if (font) {
+				setup(bytes.data(), bytes.size(), weight);
+			}
 		}
 
 		if (!font) {
 			fault("Failed to open font: '{}'", path);
 		}
 
-		std::vector<msdfgen::FontVariationAxis> axes;
-		msdfgen::listFontVariationAxes(axes, freetype, font);
+	}
+
+//	void Font::close() {
+//		destroyFont(handle);
+//		atlas.close();
+//	}
+
+	void Font::prewarm(const std::string& charset, bool wait) {
+		if (!font) {
+			return;
+		}
+
+		std::vector<int> codepoints;
+		decode_unicode(charset, codepoints);
 
-		FT_Face face = getFreeType(this->font);
-		printf("Loaded font '%s'", face->family_name);
+		for (int unicode : codepoints) {
+			if (!findGlyph(unicode)) {
+				loadUnicode(unicode, glyph_scale, glyph_range, {});
+			}
+		}
 
-		for (auto axis : axes) {
-			printf(" [Axis: '%s']", axis.name);
+		if (wait) {
+			std::unique_lock lock {queue->mutex};
+			queue->condition.wait(lock, [this] { return queue->outstanding == 0; });
 		}
 
-		printf("\n");
-		msdfgen::setFontVariationAxis(freetype, font, "Weight", weight);
+		collect({});
 
+		if (wait && key != 0 && glyphs() > saved) {
+			save_glyphs();
+		}
 	}
 
-//	void Font::close() {
-//		destroyFont(handle);
-//		atlas.close();
-//	}
+	void Font::blocking(bool enable) {
+		this->async = !enable;
+	}
 
 	float Font::getScaleForSize(float size) const {
 		return size / base;
 	}
 
-	GlyphQuad Font::getBakedQuad(float* x, float* y, float scale, int unicode, int prev, const std::function<void()>& on_resize) {
+	void Font::share(bool enable) {
+		if (!enable) {
+			shared_atlas.reset();
+			return;
+		}
 
-		GlyphQuad quad;
+		if (!shared_atlas) {
+			shared_atlas = std::make_shared<Atlas>();
+		}
+	}
 
-		double kerning = 0;
-		float iw = 1.0f / width();
-		float ih = 1.0f / height();
+	Atlas& Font::getAtlas() {
+		return *atlas;
+	}
 
-		if (prev != 0) {
-			msdfgen::getKerning(kerning, font, prev, unicode, msdfgen::FONT_SCALING_EM_NORMALIZED);
-		}
+	uint32_t Font::identifier() const {
+		return id;
+	}
+
+	bool Font::loaded() const {
+		return font != nullptr;
+	}
+
+	bool Font::isGlyphReady(int unicode) {
+		const GlyphInfo* info = findGlyph(unicode);
+		return info && info->ready;
+	}
 
-		if (kerning != 0) {
-			kerning = kerning;
+	GlyphQuad Font::getBakedQuad(float* x, float* y, float scale, int unicode, int prev, const std::function<void()>& on_resize) {
+
+		GlyphQuad quad {};
+
+		// font is still being loaded
+		if (!font) {
+			return quad;
 		}
 
-		auto pair = cdata.find(unicode);
+		const float kerning = (prev != 0) ? getKerning(prev, unicode) : 0;
+		const float iw = 1.0f / width();
+		const float ih = 1.0f / height();
+
+		collect(on_resize);
+		GlyphInfo* glyph = findGlyph(unicode);
 
-		if (pair == cdata.end()) {
-			loadUnicode(font, unicode, 64, 6, on_resize);
-			return getBakedQuad(x, y, scale, unicode, prev, on_resize);
+		if (glyph == nullptr) {
+			loadUnicode(unicode, glyph_scale, glyph_range, on_resize);
+			glyph = findGlyph(unicode);
 		}
 
-		GlyphInfo& info = pair->second;
+		const GlyphInfo& info = *glyph;
+
+		// the glyph will be drawn once it is generated, for now only make space for it
+		if (!info.ready) {
+			*x += info.advance * scale;
+			return quad;
+		}
 
 		int round_x = (int) floor((*x + info.xoff * scale) + 0.5f);
 		int round_y = (int) floor((*y + info.yoff * scale) + 0.5f);
@@ -162,26 +522,31 @@ namespace plgl {
 		quad.t0 = info.y1 * ih;
 		quad.s1 = info.x1 * iw;
 		quad.t1 = info.y0 * ih;
+		quad.layer = info.layer;
 
 		*x += info.advance * scale;
 		return quad;
 
 	}
 
-	void Font::use() const {
-		atlas.use();
+	void Font::use() {
+		atlas->use();
 	}
 
 	int Font::handle() const {
-		return atlas.handle();
+		return atlas->handle();
 	}
 
 	int Font::width() const {
-		return atlas.width();
+		return atlas->width();
 	}
 
 	int Font::height() const {
-		return atlas.height();
+		return atlas->height();
+	}
+
+	bool Font::layered() const {
+		return true;
 	}
 
 }
\ No newline at end of file
@@ -9,14 +9,21 @@ namespace msdfgen {
 
 namespace plgl {
 
+	class Loader;
+
 	struct GlyphInfo {
-		double x0, y0, x1, y1;
-		double xoff, yoff, advance;
+		float x0, y0, x1, y1;
+		float xoff, yoff, advance;
+		int layer;
+
+		// false while the glyph image is still being generated, such glyphs only advance the pen
+		bool ready;
 	};
 
 	struct GlyphQuad {
 		float x0, y0, s0, t0;
 		float x1, y1, s1, t1;
+		float layer;
 	};
 
 	class Font : public PixelBuffer {
@@ -25,26 +32,145 @@ namespace plgl {
 
 			static constexpr int resolution = 64;
 
+			/// Glyphs below this codepoint (ASCII and Latin-1) are kept in flat tables
+			static constexpr int latin = 256;
+
 		private:
 
+			static std::string cache_directory;
+			static std::shared_ptr<Atlas> shared_atlas;
+
+			// glyph images generated by the worker threads, waiting to be placed in the atlas
+			struct Baked {
+				int unicode;
+				Image image;
+			};
+
+			// state shared with the worker threads, outlives the font if needed
+			struct Queue {
+				std::mutex mutex;
+				std::condition_variable condition;
+				std::vector<Baked> finished;
+				std::atomic_int outstanding = 0;
+				std::atomic_bool ready = false;
+			};
+
+			static std::atomic_uint32_t counter;
+
 			float base;
-			msdfgen::FontHandle* font;
-			Atlas atlas;
+			uint32_t id;
+			msdfgen::FontHandle* font = nullptr;
+			std::vector<uint8_t> bytes;
+			std::shared_ptr<Atlas> atlas;
 			ankerl::unordered_dense::map<int, GlyphInfo> cdata;
 
-			bool loadUnicode(msdfgen::FontHandle* font, uint32_t unicode, float scale, float range, const std::function<void()>& on_resize);
+			// common glyphs and kerning pairs are looked up directly by codepoint
+			GlyphInfo latin_glyphs[latin];
+			std::bitset<latin> latin_loaded;
+			std::vector<float> latin_kerning;
+			ankerl::unordered_dense::map<uint64_t, float> kerning_pairs;
+			std::shared_ptr<Queue> queue;
+			bool async = true;
+
+			// identifies the face, weight and glyph parameters in the glyph cache, 0 if not cached
+			uint64_t key = 0;
+			size_t saved = 0;
+
+			friend class Loader;
+
+			/// Create font with no face, nothing is drawn until the Loader opens it
+			Font();
+
+			/// Open font file loaded into memory, the bytes are kept alive by the font
+			void open(std::vector<uint8_t>&& bytes, const std::string& name, int weight);
+			void setup(const uint8_t* data, size_t size, int weight);
+
+			std::string path() const;
+			void load_glyphs();
+			void save_glyphs();
+
+			/// Start generating the given glyph, in the background unless the font is blocking
+			void loadUnicode(uint32_t unicode, float scale, float range, const std::function<void()>& on_resize);
+
+			/// Find the given glyph, returns null if it was never loaded
+			GlyphInfo* findGlyph(int unicode);
+
+			/// Get the given glyph, adding an empty entry if it was never loaded
+			GlyphInfo& insertGlyph(int unicode);
+			void eraseGlyph(int unicode);
+
+			/// Number of loaded glyphs (ready or not)
+			size_t glyphs() const;
+
+			/// Kerning between the two glyphs in em units, queried from FreeType only once for every pair
+			float getKerning(int prev, int unicode);
+
+			/// Place generated glyph images in the atlas
+			void collect(const std::function<void()>& on_resize);
+			void place(uint32_t unicode, const ImageView& image, const std::function<void()>& on_resize);
 
 		public:
 
 			Font(const char* path, int weight = 400);
+			Font(Font&& other) = default;
+			~Font();
+
+			/**
+			 * @brief Enable glyph cache
+			 *
+			 * Generated glyphs are stored in the given directory, when the font is destroyed,
+			 * and loaded back when the same font face is opened again with the same weight, so
+			 * the atlas starts out with all the glyphs used in previous runs. Pass an empty string to disable the cache.
+			 *
+			 * @param[in] path Path to the cache directory, it will be created if needed
+			 */
+			static void cache(const std::string& path);
+
+			/**
+			 * @brief Share one atlas between fonts
+			 *
+			 * Fonts created while sharing is enabled place their glyphs into one common atlas,
+			 * so text using any mix of them can be drawn in a single batch. Each font still keeps
+			 * its own glyph table, so glyphs are identified by both the font and the codepoint.
+			 *
+			 * @param[in] enable False stops new fonts from using the shared atlas, existing fonts keep using it
+			 */
+			static void share(bool enable);
+
+			/// Texture holding the glyphs of this font, possibly shared with other fonts
+			Atlas& getAtlas();
+
+			/**
+			 * @brief Generate glyphs ahead of time.
+			 *
+			 * Starts generating all the glyphs of the given UTF-8 string on the worker threads,
+			 * glyphs that are not ready yet when drawn are skipped, only advancing the text position.
+			 *
+			 * @param[in] charset Characters to generate
+			 * @param[in] wait    Return only once all the glyphs are ready
+			 */
+			void prewarm(const std::string& charset, bool wait = false);
+
+			/// When enabled missing glyphs are generated right away, stalling the draw, instead of in the background
+			void blocking(bool enable);
+
+			/// Unique for each font created during the program run, unlike its address
+			uint32_t identifier() const;
+
+			/// False until the font face is opened
+			bool loaded() const;
+
+			/// Check if the glyph was generated and placed in the atlas
+			bool isGlyphReady(int unicode);
 
 			float getScaleForSize(float size) const;
 			GlyphQuad getBakedQuad(float* x, float* y, float scale, int code, int prev, const std::function<void()>& on_resize);
 
-			void use() const final;
+			void use() final;
 			int handle() const final;
 			int width() const final;
 			int height() const final;
+			bool layered() const final;
 	};
 
 }
@@ -0,0 +1,106 @@
+
+#include "framebuffer.hpp"
+#include "util.hpp"
+#include "state.hpp"
+
+namespace plgl {
+
+	/*
+	 * Framebuffer
+	 */
+
+	void Framebuffer::release() {
+		if (fbo) impl::GLState::deleteFramebuffer(fbo);
+		if (tid) impl::GLState::deleteTexture(tid);
+		if (rbo) glDeleteRenderbuffers(1, &rbo);
+		if (dbo) glDeleteRenderbuffers(1, &dbo);
+
+		fbo = tid = rbo = dbo = 0;
+	}
+
+	Framebuffer::Framebuffer(int samples, bool depth)
+	: samples(samples), depth(depth) {}
+
+	Framebuffer::~Framebuffer() {
+		release();
+	}
+
+	void Framebuffer::resize(int width, int height) {
+		if (fbo && w == width && h == height) {
+			return;
+		}
+
+		release();
+
+		this->w = width;
+		this->h = height;
+
+		glGenFramebuffers(1, &fbo);
+		impl::GLState::bindFramebuffer(GL_FRAMEBUFFER, fbo);
+
+		if (samples > 0) {
+			glGenRenderbuffers(1, &rbo);
+			glBindRenderbuffer(GL_RENDERBUFFER, rbo);
+			glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, GL_RGBA8, w, h);
+			glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, rbo);
+		} else {
+			glGenTextures(1, &tid);
+			impl::GLState::bindTexture(GL_TEXTURE_2D, tid);
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+			// filters often sample at a different resolution, so we need proper filtering
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+			glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, tid, 0);
+		}
+
+		if (depth) {
+			glGenRenderbuffers(1, &dbo);
+			glBindRenderbuffer(GL_RENDERBUFFER, dbo);
+			glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, GL_DEPTH_COMPONENT24, w, h);
+			glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, dbo);
+		}
+
+		if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+			fault("Failed to create framebuffer of size ({}, {})!", w, h);
+		}
+	}
+
+	void Framebuffer::bind() {
+		impl::GLState::bindFramebuffer(GL_FRAMEBUFFER, fbo);
+		glViewport(0, 0, w, h);
+	}
+
+	void Framebuffer::blit(GLuint target, int width, int height) {
+		impl::GLState::bindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+		impl::GLState::bindFramebuffer(GL_DRAW_FRAMEBUFFER, target);
+
+		// multisampled framebuffers can only be resolved at the same size
+		GLenum filter = (samples > 0 || (w == width && h == height)) ? GL_NEAREST : GL_LINEAR;
+		glBlitFramebuffer(0, 0, w, h, 0, 0, width, height, GL_COLOR_BUFFER_BIT, filter);
+	}
+
+	GLuint Framebuffer::framebuffer() const {
+		return fbo;
+	}
+
+	void Framebuffer::use() {
+		impl::GLState::bindTexture(GL_TEXTURE_2D, tid);
+	}
+
+	int Framebuffer::handle() const {
+		return tid;
+	}
+
+	int Framebuffer::width() const {
+		return w;
+	}
+
+	int Framebuffer::height() const {
+		return h;
+	}
+
+}
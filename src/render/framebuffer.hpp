@@ -0,0 +1,60 @@
+#pragma once
+
+#include "texture.hpp"
+
+namespace plgl {
+
+	/**
+	 * Offscreen render target, if created with samples
+	 * the color is stored in a multisampled renderbuffer and needs to be
+	 * resolved into a normal framebuffer before it can be sampled,
+	 * optionally a depth buffer can also be attached
+	 */
+	class Framebuffer : public PixelBuffer {
+
+		private:
+
+			GLuint fbo = 0;
+			GLuint tid = 0;
+			GLuint rbo = 0;
+			GLuint dbo = 0;
+			int w = 0, h = 0, samples;
+			bool depth;
+
+			void release();
+
+		public:
+
+			Framebuffer(int samples = 0, bool depth = false);
+			~Framebuffer();
+
+			Framebuffer(const Framebuffer& other) = delete;
+			Framebuffer& operator = (const Framebuffer& other) = delete;
+
+			/// (Re)allocate attachments if the size changed
+			void resize(int width, int height);
+
+			/// Bind this framebuffer as the render target and set the viewport
+			void bind();
+
+			/// Copy (and resolve) the color attachment into another framebuffer, 0 is the window
+			void blit(GLuint target, int width, int height);
+
+			/// Get OpenGL Framebuffer handle
+			GLuint framebuffer() const;
+
+			/// Bind the color attachment, only valid for non-multisampled framebuffers
+			void use() override;
+
+			/// Get OpenGL Texture handle of the color attachment
+			int handle() const override;
+
+			/// Get framebuffer width in pixels
+			int width() const override;
+
+			/// Get framebuffer height in pixels
+			int height() const override;
+
+	};
+
+}
@@ -1,6 +1,7 @@
 
 #include "image.hpp"
 #include "util.hpp"
+#include "ops.hpp"
 
 namespace plgl {
 
@@ -45,20 +46,123 @@ namespace plgl {
 	}
 
 	/*
-	 * Image
+	 * ImageView
 	 */
 
-	Image::Image() {}
+	ImageView::ImageView(const void* pixels, int w, int h, int c, size_t stride)
+	: pixels(static_cast<const uint8_t*>(pixels)), w(w), h(h), c(c), bytes(stride ? stride : w * c) {}
+
+	ImageView ImageView::view(int x, int y, int w, int h) const {
+		if (x < 0 || y < 0 || x + w > (int) this->w || y + h > (int) this->h) {
+			fault("Can't create view of region ({}, {}, {}, {}) in image of size ({}, {})!", x, y, w, h, this->w, this->h);
+		}
+
+		return {pixel(x, y), w, h, (int) c, bytes};
+	}
+
+	const uint8_t* ImageView::row(size_t y) const {
+		return pixels + y * bytes;
+	}
+
+	const uint8_t* ImageView::pixel(size_t x, size_t y) const {
+		return row(y) + x * c;
+	}
+
+	size_t ImageView::width() const {
+		return w;
+	}
+
+	size_t ImageView::height() const {
+		return h;
+	}
+
+	size_t ImageView::channels() const {
+		return c;
+	}
+
+	size_t ImageView::stride() const {
+		return bytes;
+	}
+
+	bool ImageView::contiguous() const {
+		return bytes == w * c || h <= 1;
+	}
+
+	bool ImageView::opaque() const {
+
+		// 1 and 3 channel images have no alpha
+		if (c == 1 || c == 3) {
+			return true;
+		}
+
+		uint8_t alpha = 255;
+
+		for (size_t y = 0; y < h; y ++) {
+			const uint8_t* line = row(y);
+
+			// alpha is always the last channel
+			for (size_t i = c - 1; i < w * c; i += c) {
+				alpha &= line[i];
+			}
+		}
+
+		return alpha == 255;
+	}
+
+	/*
+	 * Image
+	 */
 
 	Image::Image(Type type, void* pixels, int w, int h, int c)
 	: type(type), pixels(pixels), w(w), h(h), c(c) {}
 
+	Image::~Image() {
+		close();
+	}
+
+	Image::Image(Image&& other) noexcept
+	: type(other.type), pixels(other.pixels), w(other.w), h(other.h), c(other.c) {
+		other.type = UNBACKED;
+		other.pixels = nullptr;
+	}
+
+	Image& Image::operator = (Image&& other) noexcept {
+		if (this != &other) {
+			close();
+
+			type = other.type;
+			pixels = other.pixels;
+			w = other.w;
+			h = other.h;
+			c = other.c;
+
+			other.type = UNBACKED;
+			other.pixels = nullptr;
+		}
+
+		return *this;
+	}
+
 	void Image::close() {
 		if (pixels != nullptr) {
 			if (type == STB_IMAGE) stbi_image_free(pixels);
 			if (type == MALLOCED) free(pixels);
 			pixels = nullptr;
 		}
+
+		type = UNBACKED;
+	}
+
+	ImageView Image::view() const {
+		return {pixels, (int) w, (int) h, (int) c};
+	}
+
+	ImageView Image::view(int x, int y, int w, int h) const {
+		return view().view(x, y, w, h);
+	}
+
+	Image::operator ImageView () const {
+		return view();
 	}
 
 	void Image::resize(int w, int h) {
@@ -69,30 +173,12 @@ namespace plgl {
 		Image buffer = Image::allocate(w, h, channels());
 		buffer.blit(0, 0, *this);
 
-		// no matter how our image was allocated, free it now
-		close();
-
-		this->pixels = buffer.pixels;
-		this->w = w;
-		this->h = h;
+		// the old buffer is freed by the assignment
+		*this = std::move(buffer);
 	}
 
-	void Image::blit(int ox, int oy, Image& image) {
-		if (ox < 0 || oy < 0) {
-			fault("Can't blit an image at negative offset ({}, {})!", ox, oy);
-		}
-
-		if (ox + image.width() > w || oy + image.height() > h) {
-			fault("Can't blit an image of size ({}, {}) at offset ({}, {}) as it would fall outside target image bounds ({}, {})!", ox, oy, image.width(), image.height(), w, h);
-		}
-
-		if (image.channels() != channels()) {
-			fault("Can't blit an image with {} channels into an image with {} channels!", image.channels(), channels());
-		}
-
-		for (int y = 0; y < (int) image.height(); y ++) {
-			memcpy(pixel(ox, oy + y).data(), image.pixel(0, y).data(), image.width() * image.channels());
-		}
+	void Image::blit(int ox, int oy, const ImageView& image) {
+		ops::blit(*this, ox, oy, image);
 	}
 
 	void Image::clear(std::initializer_list<uint8_t> value) {
@@ -100,18 +186,11 @@ namespace plgl {
 	}
 
 	void Image::fill(int ox, int oy, int ow, int oh, std::initializer_list<uint8_t> value) {
-		int ex = ox + ow;
-		int ey = oy + oh;
-
 		if ((int) value.size() != channels()) {
 			fault("Can't clear image with {} channels using value with {} channels!", channels(), value.size());
 		}
 
-		for (int y = oy; y < (int) ey; y ++) {
-			for (int x = ox; x < (int) ex; x++) {
-				memcpy(pixel(x, y).data(), value.begin(), c);
-			}
-		}
+		ops::fill(*this, ox, oy, ow, oh, value.begin());
 	}
 
 	Pixel Image::pixel(int x, int y) {
@@ -153,6 +232,10 @@ namespace plgl {
 		return c;
 	}
 
+	bool Image::opaque() const {
+		return view().opaque();
+	}
+
 	const void* Image::data() const {
 		return pixels;
 	}
@@ -36,6 +36,66 @@ namespace plgl {
 
 	};
 
+	/**
+	 * @brief Non-owning reference to pixel data.
+	 *
+	 * Describes a rectangle of pixels inside some larger buffer, rows
+	 * don't need to be adjacent in memory, each one starts 'stride' bytes after the previous one.
+	 * Views can be taken of a whole Image, of a part of one, or of any external buffer, and are
+	 * accepted wherever pixels only need to be read, so sub-regions never have to be copied out first.
+	 * The referenced memory must stay alive while the view is used.
+	 */
+	class ImageView {
+
+		private:
+
+			const uint8_t* pixels = nullptr;
+			size_t w = 0, h = 0, c = 0;
+			size_t bytes = 0;
+
+		public:
+
+			ImageView() = default;
+
+			/// View external buffer, if stride is 0 rows are assumed to be tightly packed
+			ImageView(const void* pixels, int w, int h, int c, size_t stride = 0);
+
+			/// Create a view of a sub-rectangle of this view
+			ImageView view(int x, int y, int w, int h) const;
+
+			/// returns a pointer to the first pixel of the given row
+			const uint8_t* row(size_t y) const;
+
+			/// returns a pointer to the given pixel
+			const uint8_t* pixel(size_t x, size_t y) const;
+
+			/// returns the width, in pixels, of the view
+			size_t width() const;
+
+			/// returns the height, in pixels, of the view
+			size_t height() const;
+
+			/// returns the number of channels (bytes) per pixel
+			size_t channels() const;
+
+			/// returns the distance, in bytes, between the starts of two rows
+			size_t stride() const;
+
+			/// checks if all rows are adjacent in memory
+			bool contiguous() const;
+
+			/// checks if every pixel in this view is fully opaque
+			bool opaque() const;
+
+	};
+
+	/**
+	 * @brief Owned pixel buffer.
+	 *
+	 * Images own their memory and free it when destroyed, they can't be copied, only
+	 * moved, so there is always exactly one owner. Use view() to pass (parts of) an
+	 * image around without copying, and close() to free the memory early.
+	 */
 	class Image {
 
 		private:
@@ -46,17 +106,34 @@ namespace plgl {
 				UNBACKED
 			};
 
-			Type type;
-			void* pixels;
-			size_t w, h, c;
+			Type type = UNBACKED;
+			void* pixels = nullptr;
+			size_t w = 0, h = 0, c = 0;
+
+			Image(Type type, void* pixels, int w, int h, int c);
 
 		public:
 
-			Image();
-			Image(Type type, void* pixels, int w, int h, int c);
+			Image() = default;
+			~Image();
+
+			Image(const Image& other) = delete;
+			Image& operator = (const Image& other) = delete;
+
+			Image(Image&& other) noexcept;
+			Image& operator = (Image&& other) noexcept;
 
+			/// Free the pixel data, the image is empty after this call
 			void close();
 
+			/// Create a view of the whole image
+			ImageView view() const;
+
+			/// Create a view of a sub-rectangle of the image
+			ImageView view(int x, int y, int w, int h) const;
+
+			operator ImageView () const;
+
 			/**
 			 * @brief Resize image
 			 *
@@ -78,7 +155,7 @@ namespace plgl {
 			 * @param oy    Offset, in pixels, from the bottom of this image
 			 * @param image The image that should be pasted
 			 */
-			void blit(int ox, int oy, Image& image);
+			void blit(int ox, int oy, const ImageView& image);
 
 			/**
 			 * @brief Clear image
@@ -165,6 +242,9 @@ namespace plgl {
 			/// returns the number of channels (bytes) per pixel
 			size_t channels() const;
 
+			/// checks if every pixel in this image is fully opaque
+			bool opaque() const;
+
 			/// returns a pointer to the start of images' data buffer
 			const void* data() const;
 
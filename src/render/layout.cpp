@@ -0,0 +1,259 @@
+
+#include "layout.hpp"
+#include "globals.hpp"
+#include "utf8.hpp"
+
+namespace plgl {
+
+	static bool is_space(int unicode) {
+		return unicode == ' ' || unicode == '\t';
+	}
+
+	/*
+	 * TextLayout
+	 */
+
+	void TextLayout::align() {
+		if (style.align == ALIGN_LEFT) {
+			return;
+		}
+
+		const float box = (style.wrap > 0) ? style.wrap : advance;
+		const float factor = (style.align == ALIGN_CENTER) ? 0.5f : 1.0f;
+
+		for (size_t i = 0; i < rows.size(); i ++) {
+			const size_t last = (i + 1 < rows.size()) ? rows[i + 1].first : quads.size();
+
+			// keep glyphs on whole pixels, as placed by the font
+			const float shift = floor((box - rows[i].width) * factor + 0.5f);
+
+			for (size_t q = rows[i].first; q < last; q ++) {
+				quads[q].x0 += shift;
+				quads[q].x1 += shift;
+			}
+		}
+	}
+
+	TextLayout::TextLayout(Font& font, float size, const std::string& text, const TextStyle& style) {
+		set(font, size, text, style);
+	}
+
+	void TextLayout::set(Font& font, float size, const std::string& text, const TextStyle& style) {
+		if (this->font == &font && this->size == size && this->style == style && this->string == text) {
+			return;
+		}
+
+		this->font = &font;
+		this->size = size;
+		this->string = text;
+		this->style = style;
+		this->complete = false;
+	}
+
+	bool TextLayout::update(const std::function<void()>& on_resize) {
+		if (complete || font == nullptr) {
+			return complete;
+		}
+
+		quads.clear();
+		rows.clear();
+		advance = 0;
+
+		// the face is still being opened by the loader
+		if (!font->loaded()) {
+			return false;
+		}
+
+		std::vector<int> text;
+		decode_unicode(string, text);
+
+		const float scale = font->getScaleForSize(size);
+		float x = 0;
+		float y = 0;
+		int prev = 0;
+
+		complete = true;
+		rows.push_back({0, 0});
+
+		auto emit = [&] (int unicode) {
+			GlyphQuad quad = font->getBakedQuad(&x, &y, scale, unicode, prev, on_resize);
+			prev = unicode;
+
+			// glyphs that are not generated yet only move the pen, the layout needs to be done again later
+			if (!font->isGlyphReady(unicode)) {
+				complete = false;
+				return;
+			}
+
+			if (quad.x0 != quad.x1) {
+				quads.push_back(quad);
+			}
+		};
+
+		auto newline = [&] () {
+			advance = std::max(advance, rows.back().width);
+			rows.push_back({quads.size(), 0});
+
+			// screen Y axis points down, so each line goes below the previous one
+			x = 0;
+			y += leading();
+			prev = 0;
+		};
+
+		size_t i = 0;
+
+		while (i < text.size()) {
+			const int unicode = text[i];
+
+			if (unicode == '\n') {
+				newline();
+				i ++;
+				continue;
+			}
+
+			// spaces never start a wrapped line, they are consumed by the line before it
+			if (is_space(unicode)) {
+				emit(unicode);
+				i ++;
+				continue;
+			}
+
+			size_t end = i;
+
+			while (end < text.size() && text[end] != '\n' && !is_space(text[end])) {
+				end ++;
+			}
+
+			const float start = x;
+			const size_t first = quads.size();
+
+			for (size_t j = i; j < end; j ++) {
+				emit(text[j]);
+			}
+
+			// move the whole word to the next line, unless it's the first one, then it just overflows
+			if (style.wrap > 0 && x > style.wrap && start > 0) {
+				quads.resize(first);
+				newline();
+
+				for (size_t j = i; j < end; j ++) {
+					emit(text[j]);
+				}
+			}
+
+			// trailing spaces don't count towards the line width
+			rows.back().width = x;
+			i = end;
+		}
+
+		advance = std::max(advance, rows.back().width);
+		align();
+
+		return complete;
+	}
+
+	const std::vector<GlyphQuad>& TextLayout::glyphs() const {
+		return quads;
+	}
+
+	float TextLayout::width() const {
+		return advance;
+	}
+
+	float TextLayout::height() const {
+		return size + (rows.empty() ? 0 : (rows.size() - 1) * leading());
+	}
+
+	float TextLayout::leading() const {
+		return size * style.spacing;
+	}
+
+	size_t TextLayout::lines() const {
+		return rows.size();
+	}
+
+	TextBounds TextLayout::bounds() const {
+		if (quads.empty()) {
+			return {0, 0, 0, 0};
+		}
+
+		float x0 = std::numeric_limits<float>::max();
+		float y0 = std::numeric_limits<float>::max();
+		float x1 = std::numeric_limits<float>::lowest();
+		float y1 = std::numeric_limits<float>::lowest();
+
+		for (const GlyphQuad& quad : quads) {
+			x0 = std::min({x0, quad.x0, quad.x1});
+			y0 = std::min({y0, quad.y0, quad.y1});
+			x1 = std::max({x1, quad.x0, quad.x1});
+			y1 = std::max({y1, quad.y0, quad.y1});
+		}
+
+		return {x0, y0, x1 - x0, y1 - y0};
+	}
+
+	Font* TextLayout::getFont() const {
+		return font;
+	}
+
+	float TextLayout::getSize() const {
+		return size;
+	}
+
+	const std::string& TextLayout::getText() const {
+		return string;
+	}
+
+	const TextStyle& TextLayout::getStyle() const {
+		return style;
+	}
+
+}
+
+namespace plgl::impl {
+
+	/*
+	 * LayoutCache
+	 */
+
+	uint64_t LayoutCache::key(const Font& font, float size, const std::string& text, const TextStyle& style) {
+		const uint32_t id = font.identifier();
+		const float options[] = {size, style.wrap, (float) style.align, style.spacing};
+
+		return hash(text, hash(options, sizeof(options), hash(&id, sizeof(id))));
+	}
+
+	TextLayout& LayoutCache::get(Font& font, float size, const std::string& text, const TextStyle& style) {
+
+		// layouts used in the last frame survive, the rest is dropped, so text that changes every frame doesn't pile up
+		if (frame != frame_count) {
+			frame = frame_count;
+			previous.swap(current);
+			current.clear();
+		}
+
+		const uint64_t entry = key(font, size, text, style);
+		auto it = current.find(entry);
+
+		if (it == current.end()) {
+			auto old = previous.find(entry);
+
+			if (old != previous.end()) {
+				it = current.emplace(entry, std::move(old->second)).first;
+			} else {
+				it = current.emplace(entry, TextLayout {}).first;
+			}
+		}
+
+		// on collision the entry is simply replaced
+		TextLayout& layout = it->second;
+		layout.set(font, size, text, style);
+		return layout;
+	}
+
+	void LayoutCache::clear() {
+		current.clear();
+		previous.clear();
+	}
+
+}
@@ -0,0 +1,131 @@
+#pragma once
+
+#include "external.hpp"
+#include "font.hpp"
+
+namespace plgl {
+
+	enum TextAlign {
+		ALIGN_LEFT,
+		ALIGN_CENTER,
+		ALIGN_RIGHT
+	};
+
+	/// Options used to break text into lines
+	struct TextStyle {
+
+		/// lines are broken at spaces to fit in this width, zero disables wrapping
+		float wrap = 0;
+
+		/// alignment of each line, relative to the wrap width, or the widest line if not wrapping
+		TextAlign align = ALIGN_LEFT;
+
+		/// distance between baselines, as a multiple of the text size
+		float spacing = 1.25f;
+
+		bool operator==(const TextStyle& other) const = default;
+
+	};
+
+	/// Box relative to the text origin
+	struct TextBounds {
+		float x, y, w, h;
+	};
+
+	/**
+	 * @brief Text with its glyphs already positioned.
+	 *
+	 * Decoding the string, looking up glyph metrics and kerning, and breaking it into lines is done
+	 * once, drawing the layout only translates the stored quads to the given position. Build it once for text
+	 * that doesn't change between frames, while some glyphs are still being generated the layout is
+	 * redone on each draw, until all of them are ready. The origin is on the baseline of the first line.
+	 *
+	 * @see plgl::text(float, float, TextLayout&)
+	 */
+	class TextLayout {
+
+		private:
+
+			struct Line {
+				size_t first;
+				float width;
+			};
+
+			Font* font = nullptr;
+			float size = 0;
+			std::string string;
+			TextStyle style;
+
+			// glyph quads relative to the text origin
+			std::vector<GlyphQuad> quads;
+			std::vector<Line> rows;
+			float advance = 0;
+			bool complete = false;
+
+			/// Shift each line to match the alignment
+			void align();
+
+		public:
+
+			TextLayout() = default;
+			TextLayout(Font& font, float size, const std::string& text, const TextStyle& style = {});
+
+			/// Change the text, this drops the stored glyphs only if anything changed
+			void set(Font& font, float size, const std::string& text, const TextStyle& style = {});
+
+			/// Position glyphs again if some were still missing, returns true if the layout is complete
+			bool update(const std::function<void()>& on_resize = {});
+
+			/// Glyph quads relative to the origin of the text
+			const std::vector<GlyphQuad>& glyphs() const;
+
+			/// Advance of the widest line, trailing spaces are not included
+			float width() const;
+
+			/// Distance from the top of the first line to the baseline of the last one
+			float height() const;
+
+			/// Distance between baselines of two lines
+			float leading() const;
+
+			/// Number of lines after wrapping
+			size_t lines() const;
+
+			/// Smallest box containing all the glyph images, empty while no glyphs are ready
+			TextBounds bounds() const;
+
+			Font* getFont() const;
+			float getSize() const;
+			const std::string& getText() const;
+			const TextStyle& getStyle() const;
+
+	};
+
+	namespace impl {
+
+		/// Layouts of recently drawn strings, entries not used during the last frame are dropped
+		class LayoutCache {
+
+			private:
+
+				using Map = ankerl::unordered_dense::map<uint64_t, TextLayout>;
+
+				Map current;
+				Map previous;
+				long frame = -1;
+
+				static uint64_t key(const Font& font, float size, const std::string& text, const TextStyle& style);
+
+			public:
+
+				/// Get the layout for the given text, reusing the one from previous frames if possible
+				TextLayout& get(Font& font, float size, const std::string& text, const TextStyle& style);
+
+				/// Remove all the stored layouts
+				void clear();
+
+		};
+
+	}
+
+}
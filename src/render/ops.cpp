@@ -0,0 +1,457 @@
+
+#include "ops.hpp"
+#include "pool.hpp"
+#include "math.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#	include <emmintrin.h>
+#	define PLGL_SSE2
+#endif
+
+namespace plgl::ops {
+
+	// images smaller than this (in pixels) are not worth splitting between threads
+	static constexpr size_t parallel_threshold = 256 * 256;
+
+	/// Run 'body' for every row in [0, rows), on many threads if there is enough work
+	static void rows(size_t rows, size_t width, const std::function<void(size_t, size_t)>& body) {
+		if (rows * width < parallel_threshold) {
+			body(0, rows);
+			return;
+		}
+
+		size_t chunk = std::max<size_t>(1, parallel_threshold / std::max<size_t>(1, width));
+		impl::ThreadPool::get().parallel(rows, chunk, body);
+	}
+
+	/// Divide by 255 with rounding, exact for all products of two bytes
+	static inline int div255(int value) {
+		value += 128;
+		return (value + (value >> 8)) >> 8;
+	}
+
+	static uint8_t* row(Image& image, size_t x, size_t y) {
+		return static_cast<uint8_t*>(image.data()) + (y * image.width() + x) * image.channels();
+	}
+
+	static const uint8_t* row(const ImageView& image, size_t x, size_t y) {
+		return image.pixel(x, y);
+	}
+
+	static void bounds(const Image& target, int x, int y, int w, int h) {
+		if (x < 0 || y < 0) {
+			fault("Can't access image at negative offset ({}, {})!", x, y);
+		}
+
+		if (x + w > (int) target.width() || y + h > (int) target.height()) {
+			fault("Area of size ({}, {}) at offset ({}, {}) falls outside image bounds ({}, {})!", w, h, x, y, target.width(), target.height());
+		}
+	}
+
+	/*
+	 * Fill & Blit
+	 */
+
+	void fill(Image& image, int x, int y, int w, int h, const uint8_t* value) {
+		bounds(image, x, y, w, h);
+
+		if (w <= 0 || h <= 0) {
+			return;
+		}
+
+		const size_t c = image.channels();
+		const size_t length = w * c;
+
+		// build one row by doubling, then copy it into every row of the area
+		std::vector<uint8_t> pattern (length);
+		memcpy(pattern.data(), value, c);
+
+		for (size_t filled = c; filled < length; filled *= 2) {
+			memcpy(pattern.data() + filled, pattern.data(), std::min(filled, length - filled));
+		}
+
+		rows(h, w, [&] (size_t begin, size_t end) {
+			for (size_t i = begin; i < end; i ++) {
+				memcpy(row(image, x, y + i), pattern.data(), length);
+			}
+		});
+	}
+
+	void blit(Image& target, int x, int y, const ImageView& source) {
+		bounds(target, x, y, source.width(), source.height());
+
+		if (source.channels() != target.channels()) {
+			fault("Can't blit an image with {} channels into an image with {} channels!", source.channels(), target.channels());
+		}
+
+		const size_t length = source.width() * source.channels();
+
+		rows(source.height(), source.width(), [&] (size_t begin, size_t end) {
+			for (size_t i = begin; i < end; i ++) {
+				memcpy(row(target, x, y + i), row(source, 0, i), length);
+			}
+		});
+	}
+
+	/*
+	 * Composite & Premultiply
+	 */
+
+	// out = (a * ma + b * mb) / 255, for each of the 4 channels of 'count' pixels
+	// the multipliers are taken from the alpha of 'a', see composite() and premultiply()
+	static void blend(const uint8_t* a, const uint8_t* b, uint8_t* out, size_t count, bool over) {
+		size_t i = 0;
+
+#ifdef PLGL_SSE2
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i full = _mm_set1_epi16(255);
+		const __m128i bias = _mm_set1_epi16(128);
+		const __m128i color = _mm_set_epi16(0, -1, -1, -1, 0, -1, -1, -1);
+
+		// unpacked to 16 bits per channel two pixels fit in each register
+		auto mix = [&] (__m128i sa, __m128i sb) {
+			__m128i alpha = _mm_shufflehi_epi16(_mm_shufflelo_epi16(sa, 0xFF), 0xFF);
+			__m128i ma = _mm_or_si128(_mm_and_si128(alpha, color), _mm_andnot_si128(color, full));
+			__m128i mb = _mm_sub_epi16(full, alpha);
+
+			__m128i sum = _mm_add_epi16(_mm_mullo_epi16(sa, ma), bias);
+
+			if (over) {
+				sum = _mm_add_epi16(sum, _mm_mullo_epi16(sb, mb));
+			}
+
+			return _mm_srli_epi16(_mm_add_epi16(sum, _mm_srli_epi16(sum, 8)), 8);
+		};
+
+		for (; i + 4 <= count; i += 4) {
+			__m128i va = _mm_loadu_si128((const __m128i*) (a + i * 4));
+			__m128i vb = over ? _mm_loadu_si128((const __m128i*) (b + i * 4)) : zero;
+
+			__m128i lo = mix(_mm_unpacklo_epi8(va, zero), _mm_unpacklo_epi8(vb, zero));
+			__m128i hi = mix(_mm_unpackhi_epi8(va, zero), _mm_unpackhi_epi8(vb, zero));
+
+			_mm_storeu_si128((__m128i*) (out + i * 4), _mm_packus_epi16(lo, hi));
+		}
+#endif
+
+		for (; i < count; i ++) {
+			const uint8_t* pa = a + i * 4;
+			const uint8_t* pb = over ? b + i * 4 : nullptr;
+			uint8_t* po = out + i * 4;
+
+			int alpha = pa[3];
+			int inverse = 255 - alpha;
+
+			for (int j = 0; j < 3; j ++) {
+				po[j] = div255(pa[j] * alpha + (over ? pb[j] * inverse : 0));
+			}
+
+			po[3] = over ? div255(alpha * 255 + pb[3] * inverse) : alpha;
+		}
+	}
+
+	void composite(Image& target, int x, int y, const ImageView& source) {
+		bounds(target, x, y, source.width(), source.height());
+
+		if (source.channels() != 4 || target.channels() != 4) {
+			fault("Can only composite 4 channel images, got {} and {} channels!", source.channels(), target.channels());
+		}
+
+		rows(source.height(), source.width(), [&] (size_t begin, size_t end) {
+			for (size_t i = begin; i < end; i ++) {
+				uint8_t* output = row(target, x, y + i);
+				blend(row(source, 0, i), output, output, source.width(), true);
+			}
+		});
+	}
+
+	void premultiply(Image& image) {
+		if (image.channels() != 4) {
+			fault("Can only premultiply 4 channel images, got {} channels!", image.channels());
+		}
+
+		rows(image.height(), image.width(), [&] (size_t begin, size_t end) {
+			for (size_t i = begin; i < end; i ++) {
+				uint8_t* line = row(image, 0, i);
+				blend(line, nullptr, line, image.width(), false);
+			}
+		});
+	}
+
+	/*
+	 * Swizzle & Convert
+	 */
+
+	void swizzle(Image& image, const std::array<int, 4>& order) {
+		const int c = image.channels();
+
+		for (int i = 0; i < c; i ++) {
+			if (order[i] < 0 || order[i] >= c) {
+				fault("Invalid swizzle, channel {} of {} channel image!", order[i], c);
+			}
+		}
+
+		rows(image.height(), image.width(), [&] (size_t begin, size_t end) {
+			uint8_t pixel[4];
+
+			for (size_t i = begin; i < end; i ++) {
+				uint8_t* line = row(image, 0, i);
+
+				for (size_t x = 0; x < image.width(); x ++) {
+					uint8_t* current = line + x * c;
+					memcpy(pixel, current, c);
+
+					for (int j = 0; j < c; j ++) {
+						current[j] = pixel[order[j]];
+					}
+				}
+			}
+		});
+	}
+
+	Image convert(const ImageView& image, int channels) {
+		const int from = image.channels();
+		const int to = channels;
+
+		if ((from != 1 && from != 3 && from != 4) || (to != 1 && to != 3 && to != 4)) {
+			fault("Can't convert image with {} channels into image with {} channels!", from, to);
+		}
+
+		Image result = Image::allocate(image.width(), image.height(), to);
+		const size_t width = image.width();
+
+		rows(image.height(), width, [&] (size_t begin, size_t end) {
+			for (size_t i = begin; i < end; i ++) {
+				const uint8_t* input = row(image, 0, i);
+				uint8_t* output = row(result, 0, i);
+
+				if (from == to) {
+					memcpy(output, input, width * from);
+					continue;
+				}
+
+				// grey to color
+				if (from == 1) {
+					for (size_t x = 0; x < width; x ++) {
+						uint8_t* pixel = output + x * to;
+						pixel[0] = pixel[1] = pixel[2] = input[x];
+						if (to == 4) pixel[3] = 255;
+					}
+
+					continue;
+				}
+
+				// color to grey
+				if (to == 1) {
+					for (size_t x = 0; x < width; x ++) {
+						const uint8_t* pixel = input + x * from;
+						output[x] = (pixel[0] * 77 + pixel[1] * 150 + pixel[2] * 29 + 128) >> 8;
+					}
+
+					continue;
+				}
+
+				// RGB <-> RGBA
+				for (size_t x = 0; x < width; x ++) {
+					const uint8_t* source = input + x * from;
+					uint8_t* target = output + x * to;
+
+					target[0] = source[0];
+					target[1] = source[1];
+					target[2] = source[2];
+					if (to == 4) target[3] = 255;
+				}
+			}
+		});
+
+		return result;
+	}
+
+	/*
+	 * Resize
+	 */
+
+	// weights use 16 bit fixed point so that the accumulation can be done in integers
+	static constexpr int precision = 16;
+
+	struct Coefficients {
+		int taps;
+		std::vector<int> start;
+		std::vector<int> count;
+		std::vector<int32_t> weights;
+	};
+
+	static double kernel(Filter filter, double x) {
+		x = std::abs(x);
+
+		if (filter == BOX) {
+			return x <= 0.5 ? 1.0 : 0.0;
+		}
+
+		if (filter == BILINEAR) {
+			return x < 1.0 ? 1.0 - x : 0.0;
+		}
+
+		if (x < 1e-8) {
+			return 1.0;
+		}
+
+		if (x >= 3.0) {
+			return 0.0;
+		}
+
+		const double px = PI * x;
+		return 3.0 * std::sin(px) * std::sin(px / 3.0) / (px * px);
+	}
+
+	static double support(Filter filter) {
+		if (filter == BOX) return 0.5;
+		if (filter == BILINEAR) return 1.0;
+		return 3.0;
+	}
+
+	/// Compute, for each output pixel, the range of input pixels and their weights
+	static Coefficients coefficients(int input, int output, Filter filter) {
+		const double scale = input / (double) output;
+		const double stretch = std::max(scale, 1.0);
+		const double radius = support(filter) * stretch;
+
+		Coefficients result;
+		result.taps = (int) std::ceil(radius) * 2 + 1;
+		result.start.resize(output);
+		result.count.resize(output);
+		result.weights.resize(output * result.taps);
+
+		std::vector<double> values (result.taps);
+
+		for (int i = 0; i < output; i ++) {
+			const double center = (i + 0.5) * scale;
+			const int first = std::max(0, (int) (center - radius + 0.5));
+			const int last = std::min(input, (int) (center + radius + 0.5));
+			const int count = std::min(last - first, result.taps);
+
+			double total = 0;
+
+			for (int j = 0; j < count; j ++) {
+				values[j] = kernel(filter, (first + j - center + 0.5) / stretch);
+				total += values[j];
+			}
+
+			// the box can miss all samples when upscaling, fall back to the nearest pixel
+			if (total == 0) {
+				std::fill(values.begin(), values.begin() + count, 0.0);
+				values[std::clamp((int) center - first, 0, count - 1)] = total = 1;
+			}
+
+			result.start[i] = first;
+			result.count[i] = count;
+
+			for (int j = 0; j < count; j ++) {
+				result.weights[i * result.taps + j] = (int32_t) std::lround(values[j] / total * (1 << precision));
+			}
+		}
+
+		return result;
+	}
+
+	static inline uint8_t clamp(int32_t value) {
+		value = (value + (1 << (precision - 1))) >> precision;
+		return (uint8_t) std::clamp(value, 0, 255);
+	}
+
+	static Image horizontal(const ImageView& image, int width, Filter filter) {
+		const int c = image.channels();
+		const Coefficients coeffs = coefficients(image.width(), width, filter);
+		Image result = Image::allocate(width, image.height(), c);
+
+		rows(image.height(), width, [&] (size_t begin, size_t end) {
+			for (size_t y = begin; y < end; y ++) {
+				const uint8_t* input = row(image, 0, y);
+				uint8_t* output = row(result, 0, y);
+
+				for (int x = 0; x < width; x ++) {
+					const int32_t* weights = coeffs.weights.data() + x * coeffs.taps;
+					const uint8_t* source = input + coeffs.start[x] * c;
+					int32_t sum[4] = {0, 0, 0, 0};
+
+					for (int j = 0; j < coeffs.count[x]; j ++) {
+						for (int k = 0; k < c; k ++) {
+							sum[k] += source[j * c + k] * weights[j];
+						}
+					}
+
+					for (int k = 0; k < c; k ++) {
+						output[x * c + k] = clamp(sum[k]);
+					}
+				}
+			}
+		});
+
+		return result;
+	}
+
+	static Image vertical(const ImageView& image, int height, Filter filter) {
+		const int c = image.channels();
+		const size_t length = image.width() * c;
+		const Coefficients coeffs = coefficients(image.height(), height, filter);
+		Image result = Image::allocate(image.width(), height, c);
+
+		rows(height, image.width(), [&] (size_t begin, size_t end) {
+			std::vector<int32_t> sum (length);
+
+			for (size_t y = begin; y < end; y ++) {
+				const int32_t* weights = coeffs.weights.data() + y * coeffs.taps;
+				std::fill(sum.begin(), sum.end(), 0);
+
+				// whole rows at once, this loop vectorizes well
+				for (int j = 0; j < coeffs.count[y]; j ++) {
+					const uint8_t* source = row(image, 0, coeffs.start[y] + j);
+					const int32_t weight = weights[j];
+
+					for (size_t i = 0; i < length; i ++) {
+						sum[i] += source[i] * weight;
+					}
+				}
+
+				uint8_t* output = row(result, 0, y);
+
+				for (size_t i = 0; i < length; i ++) {
+					output[i] = clamp(sum[i]);
+				}
+			}
+		});
+
+		return result;
+	}
+
+	Image resize(const ImageView& image, int width, int height, Filter filter) {
+		if (width <= 0 || height <= 0) {
+			fault("Can't resize image to ({}, {})!", width, height);
+		}
+
+		const bool scale_x = width != (int) image.width();
+		const bool scale_y = height != (int) image.height();
+
+		if (!scale_x && !scale_y) {
+			return convert(image, image.channels());
+		}
+
+		if (!scale_x) return vertical(image, height, filter);
+		if (!scale_y) return horizontal(image, width, filter);
+
+		// do the pass that shrinks the image the most first, so the second one has less work
+		Image temporary, result;
+
+		if ((size_t) width * image.height() <= image.width() * (size_t) height) {
+			temporary = horizontal(image, width, filter);
+			result = vertical(temporary, height, filter);
+		} else {
+			temporary = vertical(image, height, filter);
+			result = horizontal(temporary, width, filter);
+		}
+
+		temporary.close();
+		return result;
+	}
+
+}
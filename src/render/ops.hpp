@@ -0,0 +1,50 @@
+#pragma once
+
+#include "image.hpp"
+
+/**
+ * Bulk image processing kernels, all of them work on whole
+ * rows at a time and large images are split between the worker threads
+ */
+namespace plgl::ops {
+
+	enum Filter {
+		BOX,      ///< Average of all covered pixels, best for shrinking by large factors
+		BILINEAR, ///< Linear interpolation (tent filter)
+		LANCZOS   ///< Three lobe Lanczos windowed sinc, sharpest but slowest
+	};
+
+	/// Fill an area of the image with a value of exactly 'channels()' bytes
+	void fill(Image& image, int x, int y, int w, int h, const uint8_t* value);
+
+	/// Copy the source image into the target at the given offset, both must have the same channel count
+	void blit(Image& target, int x, int y, const ImageView& source);
+
+	/**
+	 * @brief Alpha blend one image over another
+	 *
+	 * Draws the 4 channel source image over the 4 channel target, colors are blended
+	 * the same way the renderer does it (source alpha, one minus source alpha) and
+	 * the resulting alpha is the combined coverage of both images
+	 */
+	void composite(Image& target, int x, int y, const ImageView& source);
+
+	/// Multiply the color channels of a 4 channel image by its alpha
+	void premultiply(Image& image);
+
+	/// Reorder channels in place, output channel 'i' is taken from the input channel 'order[i]'
+	void swizzle(Image& image, const std::array<int, 4>& order);
+
+	/**
+	 * @brief Change channel count
+	 *
+	 * Converts between 1 (grey), 3 (RGB) and 4 (RGBA) channel images, grey values
+	 * are copied into all color channels, color is reduced to grey using Rec. 601 luma,
+	 * missing alpha is set to fully opaque and dropped alpha is ignored
+	 */
+	Image convert(const ImageView& image, int channels);
+
+	/// Create a scaled copy of the image
+	Image resize(const ImageView& image, int width, int height, Filter filter = BILINEAR);
+
+}
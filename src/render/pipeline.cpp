@@ -11,13 +11,13 @@ namespace plgl {
 		static const char* vertex = R"(
 			#version 330 core
 
-			layout (location = 0) in vec2 iPos;
+			layout (location = 0) in vec3 iPos;
 			layout (location = 2) in vec4 iColor;
 
 			out vec4 vColor;
 
 			void main(){
-				gl_Position = vec4(iPos.xy, -1.0, 1.0);
+				gl_Position = vec4(iPos, 1.0);
 				vColor = iColor;
 			}
 		)";
@@ -38,21 +38,23 @@ namespace plgl {
 		return shader;
 	}
 
-	Shader& Pipeline::getImageShader() {
+	Shader& Pipeline::getImageShader(bool layered) {
 		static const char* vertex = R"(
 			#version 330 core
 
-			layout (location = 0) in vec2 iPos;
-			layout (location = 1) in vec2 iTex;
+			layout (location = 0) in vec3 iPos;
+			layout (location = 1) in vec3 iTex;
 			layout (location = 2) in vec4 iColor;
 
 			out vec4 vColor;
 			out vec2 vTex;
+			flat out float vLayer;
 
 			void main(){
-				gl_Position = vec4(iPos.xy, -1.0, 1.0);
+				gl_Position = vec4(iPos, 1.0);
 				vColor = iColor;
-				vTex = iTex;
+				vTex = iTex.xy;
+				vLayer = iTex.z;
 			}
 		)";
 
@@ -71,6 +73,27 @@ namespace plgl {
 			}
 		)";
 
+		static const char* layered_fragment = R"(
+			#version 330 core
+
+			uniform sampler2DArray uSampler;
+
+			in vec4 vColor;
+			in vec2 vTex;
+			flat in float vLayer;
+
+			out vec4 fColor;
+
+			void main(){
+				fColor = texture(uSampler, vec3(vTex, vLayer)).rgba * vColor;
+			}
+		)";
+
+		if (layered) {
+			static Shader shader {vertex, layered_fragment};
+			return shader;
+		}
+
 		static Shader shader {vertex, fragment};
 		return shader;
 	}
@@ -79,27 +102,30 @@ namespace plgl {
 		static const char* vertex = R"(
 			#version 330 core
 
-			layout (location = 0) in vec2 iPos;
-			layout (location = 1) in vec2 iTex;
+			layout (location = 0) in vec3 iPos;
+			layout (location = 1) in vec3 iTex;
 			layout (location = 2) in vec4 iColor;
 
 			out vec4 vColor;
 			out vec2 vTex;
+			flat out float vLayer;
 
 			void main(){
-				gl_Position = vec4(iPos.xy, -1.0, 1.0);
+				gl_Position = vec4(iPos, 1.0);
 				vColor = iColor;
-				vTex = iTex;
+				vTex = iTex.xy;
+				vLayer = iTex.z;
 			}
 		)";
 
 		static const char* fragment = R"(
 			#version 330 core
 
-			uniform sampler2D uSampler;
+			uniform sampler2DArray uSampler;
 
 			in vec4 vColor;
 			in vec2 vTex;
+			flat in float vLayer;
 
 			out vec4 fColor;
 
@@ -111,13 +137,13 @@ namespace plgl {
 			// font_size / 64 * 6
 			float range() {
 				// this, i think, is both incorrect and unadvised, but it works for now
-				vec2 unitRange = vec2(6)/vec2(textureSize(uSampler, 0));
+				vec2 unitRange = vec2(6)/vec2(textureSize(uSampler, 0).xy);
 				vec2 screenTexSize = vec2(1.0)/fwidth(vTex);
 				return max(0.5*dot(unitRange, screenTexSize), 1.0);
 			}
 
 			void main() {
-				vec3 fields = texture(uSampler, vTex).rgb;
+				vec3 fields = texture(uSampler, vec3(vTex, vLayer)).rgb;
 				float distance = median(fields.x, fields.y, fields.z);
 				float screen = range() * (distance - 0.5);
 				float opacity = clamp(screen + 0.5, 0.0, 1.0);
@@ -130,8 +156,128 @@ namespace plgl {
 		return shader;
 	}
 
-	Pipeline::Pipeline(Shader& shader, PixelBuffer* texture)
-	: buffer({}), shader(shader), texture(texture) {
+	std::unique_ptr<Shader> Pipeline::createEffectShader(Effect::Target target, const std::string& source) {
+		static const char* vertex = R"(
+			#version 330 core
+
+			layout (location = 0) in vec3 iPos;
+			layout (location = 1) in vec3 iTex;
+			layout (location = 2) in vec4 iColor;
+
+			out vec4 vColor;
+			out vec2 vTex;
+			flat out float vLayer;
+
+			void main(){
+				gl_Position = vec4(iPos, 1.0);
+				vColor = iColor;
+				vTex = iTex.xy;
+				vLayer = iTex.z;
+			}
+		)";
+
+		// full screen triangle, generated without any vertex buffer
+		static const char* filter = R"(
+			#version 330 core
+
+			out vec4 vColor;
+			out vec2 vTex;
+
+			void main(){
+				vec2 pos = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+				gl_Position = vec4(pos * 2.0 - 1.0, 0.0, 1.0);
+				vColor = vec4(1.0);
+				vTex = pos;
+			}
+		)";
+
+		static const char* preludes[] = {
+
+			// Effect::SHAPE
+			R"(
+			#version 330 core
+
+			in vec4 vColor;
+			in vec2 vTex;
+
+			out vec4 fColor;
+
+			vec4 texel(vec2 uv) {
+				return vec4(1.0);
+			}
+			)",
+
+			// Effect::IMAGE
+			R"(
+			#version 330 core
+
+			uniform sampler2D uSampler;
+
+			in vec4 vColor;
+			in vec2 vTex;
+
+			out vec4 fColor;
+
+			vec4 texel(vec2 uv) {
+				return texture(uSampler, uv);
+			}
+			)",
+
+			// Effect::FILTER
+			R"(
+			#version 330 core
+
+			uniform sampler2D uSampler;
+			uniform sampler2D uScene;
+			uniform vec2 uResolution;
+			uniform vec2 uTexel;
+
+			in vec4 vColor;
+			in vec2 vTex;
+
+			out vec4 fColor;
+
+			vec4 texel(vec2 uv) {
+				return texture(uSampler, uv);
+			}
+			)",
+
+			// Effect::IMAGE_ARRAY
+			R"(
+			#version 330 core
+
+			uniform sampler2DArray uSampler;
+
+			in vec4 vColor;
+			in vec2 vTex;
+			flat in float vLayer;
+
+			out vec4 fColor;
+
+			vec4 texel(vec2 uv) {
+				return texture(uSampler, vec3(uv, vLayer));
+			}
+			)"
+
+		};
+
+		std::string fragment = preludes[target];
+		fragment += "\n#line 1\n";
+		fragment += source;
+		fragment += "\nvoid main() { fColor = shade(vColor, vTex); }\n";
+
+		return std::make_unique<Shader>(target == Effect::FILTER ? filter : vertex, fragment.c_str());
+	}
+
+	void Pipeline::warmup() {
+		getColorShader();
+		getImageShader(false);
+		getImageShader(true);
+		getFontShader();
+	}
+
+	Pipeline::Pipeline(Shader& shader, PixelBuffer* texture, Effect* effect)
+	: buffer({}), opaque({}), shader(shader), texture(texture), effect(effect) {
 		shader.use();
 
 		if (texture) {
@@ -139,20 +285,33 @@ namespace plgl {
 		}
 	}
 
-	void Pipeline::draw() {
+	void Pipeline::draw(Buffer& target) {
 		if (texture) {
 			texture->use();
 		}
 
 		shader.use();
-		buffer.draw();
+
+		if (effect) {
+			effect->apply(shader);
+		}
+
+		target.draw();
 	}
 
-	void Pipeline::flush() {
-		if (!buffer.empty()) {
-			draw();
-			buffer.clear();
+	void Pipeline::flush(Buffer& target) {
+		if (!target.empty()) {
+			draw(target);
+			target.clear();
 		}
 	}
 
+	void Pipeline::draw() {
+		draw(buffer);
+	}
+
+	void Pipeline::flush() {
+		flush(buffer);
+	}
+
 }
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include "shader.hpp"
 #include "texture.hpp"
 #include "polygon.hpp"
+#include "effect.hpp"
 
 namespace plgl {
 
@@ -12,19 +13,33 @@ namespace plgl {
 		public:
 
 			static Shader& getColorShader();
-			static Shader& getImageShader();
+			static Shader& getImageShader(bool layered);
 			static Shader& getFontShader();
 
+			/// Start compiling all built-in shaders, without waiting for the result
+			static void warmup();
+
+			/// Wrap user provided effect source into a complete shader for the given target
+			static std::unique_ptr<Shader> createEffectShader(Effect::Target target, const std::string& source);
+
 		public:
 
 			Buffer buffer;
+			Buffer opaque;
 			Shader& shader;
 			PixelBuffer* texture;
+			Effect* effect;
 
-			Pipeline(Shader& shader, PixelBuffer* texture);
+			Pipeline(Shader& shader, PixelBuffer* texture, Effect* effect = nullptr);
 
 		public:
 
+			/// Draw data from the given buffer using this pipeline
+			void draw(Buffer& target);
+
+			/// Draw data from the given buffer and reset it
+			void flush(Buffer& target);
+
 			/// Draw data in the pipeline
 			void draw();
 
@@ -107,9 +107,23 @@ namespace plgl {
 
 	void Renderer::texture(Sprite& sprite) {
 		texture(*sprite.texture, sprite.x, sprite.y, sprite.x + sprite.w, sprite.y + sprite.h);
+		this->layer = sprite.layer;
+
+		// atlases as a whole are rarely opaque, but their sprites often are
+		this->image_opaque = isDepthSorting() && sprite.opaque();
 	}
 
-	void Renderer::texture(Texture& t, float bx, float by, float ex, float ey) {
+	void Renderer::texture(Texture& t, float bx, float by, float ex, float ey, int layer) {
+		const Sprite& region = t.sprite();
+
+		// textures in the shared atlas are drawn as a part of it
+		if (region.texture) {
+			texture(*region.texture, region.x + bx, region.y + by, region.x + ex, region.y + ey);
+			this->layer = region.layer;
+			this->image_opaque = isDepthSorting() && t.opaque();
+			return;
+		}
+
 		useTexture(t);
 
 		float w = t.width();
@@ -122,6 +136,7 @@ namespace plgl {
 
 		this->tw = std::abs(bx - ex);
 		this->th = std::abs(by - ey);
+		this->layer = layer;
 	}
 
 	void Renderer::texture(Texture& t) {
@@ -132,13 +147,52 @@ namespace plgl {
 	}
 
 	void Renderer::font(Font& f) {
+		this->text_font = &f;
 		useFont(f);
 	}
 
+	void Renderer::shader(Effect& effect) {
+		useEffect(&effect);
+	}
+
+	void Renderer::shader(Disabled disabled) {
+		useEffect(nullptr);
+	}
+
+	void Renderer::filter(Effect& effect, float scale) {
+		filters.add(effect, scale);
+	}
+
+	void Renderer::filter(Disabled disabled) {
+		filters.clear();
+	}
+
 	void Renderer::size(float s) {
 		this->text_size = s;
 	}
 
+	void Renderer::text_align(TextAlign align) {
+		this->text_style.align = align;
+	}
+
+	void Renderer::text_wrap(float width) {
+		this->text_style.wrap = width;
+	}
+
+	void Renderer::text_spacing(float spacing) {
+		this->text_style.spacing = spacing;
+	}
+
+	TextLayout& Renderer::text_layout(const std::string& str) {
+		TextLayout& layout = layouts.get(*text_font, text_size, str, text_style);
+
+		layout.update([this] () {
+			flush();
+		});
+
+		return layout;
+	}
+
 	void Renderer::arc(float x, float y, float hrad, float vrad, float start, float angle, ArcMode mode) {
 
 		float extension = getStrokeWidth();
@@ -433,13 +487,13 @@ namespace plgl {
 	void Renderer::image(float x, float y, float w, float h) {
 		use(image_pipeline);
 
-		ivert(x, y - h, bx, ey);
-		ivert(x, y, bx, by);
-		ivert(x + w , y, ex, by);
+		ivert(x, y - h, bx, ey, layer);
+		ivert(x, y, bx, by, layer);
+		ivert(x + w , y, ex, by, layer);
 
-		ivert(x, y - h, bx, ey);
-		ivert(x + w , y, ex, by);
-		ivert(x + w, y - h, ex, ey);
+		ivert(x, y - h, bx, ey, layer);
+		ivert(x + w , y, ex, by, layer);
+		ivert(x + w, y - h, ex, ey, layer);
 	}
 
 	void Renderer::image(float x, float y) {
@@ -449,33 +503,40 @@ namespace plgl {
 	}
 
 	void Renderer::text(float x, float y, const std::string& str) {
-		use(fonts_pipeline);
+		text(x, y, text_layout(str));
+	}
 
-		Font& font = (Font&) getTexture();
-		int unicode = 0;
-		int prev = 0;
-		int offset = 0;
+	void Renderer::text(float x, float y, TextLayout& layout) {
+		if (layout.getFont() == nullptr) {
+			return;
+		}
 
-		while (true) {
-			prev = unicode;
-			unicode = next_unicode(str.c_str(), &offset);
+		// the layout is always drawn with its own font, without changing the selected one,
+		// fonts that share an atlas also share the pipeline, so switching between them doesn't flush
+		use(getPipeline(Pipeline::getFontShader(), &layout.getFont()->getAtlas(), nullptr));
 
-			if (unicode == 0) {
-				break;
-			}
+		layout.update([this] () {
+			flush();
+		});
+
+		// quads are snapped to whole pixels relative to the origin, so the origin must be snapped too
+		const float ox = floor(x + 0.5f);
+		const float oy = floor(y + 0.5f);
 
-			GlyphQuad q = font.getBakedQuad(&x, &y, font.getScaleForSize(text_size), unicode, prev, [this] () {
-				flush();
-			});
+		for (const GlyphQuad& quad : layout.glyphs()) {
+			const float x0 = ox + quad.x0;
+			const float y0 = oy + quad.y0;
+			const float x1 = ox + quad.x1;
+			const float y1 = oy + quad.y1;
 
-			ivert(q.x0, q.y1, q.s0, q.t1);
-			ivert(q.x0, q.y0, q.s0, q.t0);
-			ivert(q.x1, q.y0, q.s1, q.t0);
+			ivert(x0, y1, quad.s0, quad.t1, quad.layer);
+			ivert(x0, y0, quad.s0, quad.t0, quad.layer);
+			ivert(x1, y0, quad.s1, quad.t0, quad.layer);
 
-			ivert(q.x0, q.y1, q.s0, q.t1);
-			ivert(q.x1, q.y0, q.s1, q.t0);
-			ivert(q.x1, q.y1, q.s1, q.t1);
+			ivert(x0, y1, quad.s0, quad.t1, quad.layer);
+			ivert(x1, y0, quad.s1, quad.t0, quad.layer);
+			ivert(x1, y1, quad.s1, quad.t1, quad.layer);
 		}
 	}
 
-}
\ No newline at end of file
+}
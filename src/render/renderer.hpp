@@ -11,6 +11,7 @@
 #include "arc.hpp"
 #include "atlas.hpp"
 #include "utf8.hpp"
+#include "layout.hpp"
 
 namespace plgl {
 
@@ -21,10 +22,16 @@ namespace plgl {
 			int tw, th;
 			float text_size;
 			float bx, by, ex, ey;
+			float layer;
 
 			// value in range [0, 1], lower is better
 			float draw_quality;
 
+			// positioned glyphs of recently drawn strings
+			impl::LayoutCache layouts;
+			TextStyle text_style;
+			Font* text_font = nullptr;
+
 			void slanted_line(Vec2 p1, Vec2 d1, Vec2 p2, Vec2 d2);
 
 		public:
@@ -56,14 +63,35 @@ namespace plgl {
 
 			void texture(Sprite& sprite);
 
-			void texture(Texture& t, float bx, float by, float ex, float ey);
+			void texture(Texture& t, float bx, float by, float ex, float ey, int layer = 0);
 
 			void texture(Texture& t);
 
 			void font(Font& f);
 
+			/// use a custom effect for shapes and images
+			void shader(Effect& effect);
+
+			void shader(Disabled disabled);
+
+			/// append a post-processing filter, applied at the end of each frame
+			void filter(Effect& effect, float scale = 1.0f);
+
+			void filter(Disabled disabled);
+
 			void size(float s);
 
+			void text_align(TextAlign align);
+
+			/// break text into lines no wider than the given width, zero disables wrapping
+			void text_wrap(float width);
+
+			/// distance between lines, as a multiple of the text size
+			void text_spacing(float spacing);
+
+			/// layout of the given text using the current font and text settings, shared with text()
+			TextLayout& text_layout(const std::string& str);
+
 			void arc(float x, float y, float hrad, float vrad, float start, float angle, ArcMode mode = OPEN_PIE);
 
 		public:
@@ -112,6 +140,8 @@ namespace plgl {
 
 			void text(float x, float y, const std::string& str);
 
+			void text(float x, float y, TextLayout& layout);
+
 			template<class... Args>
 			void textf(float x, float y, const std::string& str, Args&&... args) {
 				text(x, y, format(str, args...));
@@ -141,7 +171,7 @@ namespace plgl {
 				gui_box_h = h;
 			}
 
-			inline bool gui_button(int x, int y, const std::string& text) {
+			inline bool gui_button(int x, int y, const std::string& label) {
 
 				stroke(OFF);
 				fill(90, 90, 90);
@@ -153,7 +183,9 @@ namespace plgl {
 				int rw = grid_size * gui_box_w - 2 * padding_size;
 				int rh = grid_size * gui_box_h - 2 * padding_size;
 
-				if (mouse_x > rx && mouse_y > ry && mouse_x < rx + rw && mouse_y < ry + rh) {
+				bool hover = mouse_x > rx && mouse_y > ry && mouse_x < rx + rw && mouse_y < ry + rh;
+
+				if (hover) {
 					if (mouse_pressed) {
 						stroke(80, 80, 130);
 						weight(2);
@@ -169,7 +201,12 @@ namespace plgl {
 
 				size(text_size);
 				stroke(0, 0, 0);
-				textf(rx, ry + rh / 2, "ABCdef!");
+
+				// center the visible part of the label in the button
+				TextBounds box = text_layout(label).bounds();
+				text(rx + (rw - box.w) / 2 - box.x, ry + (rh - box.h) / 2 - box.y, label);
+
+				return hover && mouse_pressed;
 
 			}
 
@@ -1,15 +1,26 @@
 
 #include "shader.hpp"
 #include "util.hpp"
+#include "state.hpp"
 
 namespace plgl {
 
+	// "PLGB" in little endian, marks PLGL program binary files
+	static constexpr uint32_t binary_magic = 0x42474c50;
+
+	std::string Shader::cache_directory = "";
+
 	GLuint Shader::compile_shader(GLenum type, const char* source) {
 		GLuint shader = glCreateShader(type);
 		glShaderSource(shader, 1, &source, NULL);
 		glCompileShader(shader);
 
-		// error checking
+		// the compilation status is checked in finalize() so
+		// that the driver can compile multiple shaders at the same time
+		return shader;
+	}
+
+	void Shader::check_shader(GLuint shader) {
 		GLint compiled = GL_FALSE;
 		glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
 
@@ -22,19 +33,9 @@ namespace plgl {
 
 			fault("Shader compilation failed with error: {}", error.data());
 		}
-
-		return shader;
 	}
 
-	GLuint Shader::link_shader(GLuint vertex, GLuint fragment) {
-
-		// create shader program
-		GLuint program = glCreateProgram();
-		glAttachShader(program, vertex);
-		glAttachShader(program, fragment);
-		glLinkProgram(program);
-
-		// error checking
+	void Shader::check_program(GLuint program) {
 		GLint linked = GL_FALSE;
 		glGetProgramiv(program, GL_LINK_STATUS, &linked);
 
@@ -47,29 +48,170 @@ namespace plgl {
 
 			fault("Shader linking failed with error: {}", error.data());
 		}
+	}
 
-		return program;
+	const std::string& Shader::driver() {
+		static std::string identifier = [] () {
+			std::string result;
+
+			for (GLenum name : {GL_VENDOR, GL_RENDERER, GL_VERSION}) {
+				const char* value = (const char*) glGetString(name);
+				result += (value ? value : "?");
+				result += ';';
+			}
 
+			return result;
+		} ();
+
+		return identifier;
 	}
 
-	Shader::Shader(const char* vertex_source, const char* fragment_source) {
-		GLuint vert = compile_shader(GL_VERTEX_SHADER, vertex_source);
-		GLuint frag = compile_shader(GL_FRAGMENT_SHADER, fragment_source);
-		program = link_shader(vert, frag);
+	std::string Shader::path() const {
+		char name[32];
+		snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long) key);
+		return (std::filesystem::path {cache_directory} / name).string();
+	}
+
+	bool Shader::load_binary() {
+		std::ifstream file {path(), std::ios::binary};
+
+		if (!file) {
+			return false;
+		}
+
+		uint32_t magic = 0;
+		GLenum format = 0;
+
+		file.read((char*) &magic, sizeof(magic));
+		file.read((char*) &format, sizeof(format));
+
+		if (!file || magic != binary_magic) {
+			return false;
+		}
+
+		std::vector<char> binary {std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+		glProgramBinary(program, format, binary.data(), binary.size());
+
+		// the driver is free to reject any binary, we then just fall back to compiling
+		GLint linked = GL_FALSE;
+		glGetProgramiv(program, GL_LINK_STATUS, &linked);
+
+		return linked == GL_TRUE;
+	}
+
+	void Shader::save_binary() {
+		GLint length = 0;
+		glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+
+		if (length <= 0) {
+			return;
+		}
+
+		GLenum format = 0;
+		std::vector<char> binary (length);
+		glGetProgramBinary(program, length, nullptr, &format, binary.data());
+
+		// cache is only an optimization, ignore all IO errors
+		std::error_code error;
+		std::filesystem::create_directories(cache_directory, error);
 
+		std::ofstream file {path(), std::ios::binary | std::ios::trunc};
+		file.write((const char*) &binary_magic, sizeof(binary_magic));
+		file.write((const char*) &format, sizeof(format));
+		file.write(binary.data(), binary.size());
+	}
+
+	void Shader::finalize() {
+		if (vert == 0) {
+			return;
+		}
+
+		check_shader(vert);
+		check_shader(frag);
+		check_program(program);
+
+		glDetachShader(program, vert);
+		glDetachShader(program, frag);
 		glDeleteShader(vert);
 		glDeleteShader(frag);
+
+		vert = 0;
+		frag = 0;
+
+		if (key != 0) {
+			save_binary();
+		}
+	}
+
+	void Shader::cache(const std::string& path) {
+		cache_directory = path;
+	}
+
+	bool Shader::parallel() {
+		if (GLAD_GL_KHR_parallel_shader_compile) {
+			glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+			return true;
+		}
+
+		return false;
+	}
+
+	Shader::Shader(const char* vertex_source, const char* fragment_source) {
+		program = glCreateProgram();
+
+		if (!cache_directory.empty() && (GLAD_GL_VERSION_4_1 || GLAD_GL_ARB_get_program_binary)) {
+			// sources must be hashed as strings, a plain pointer would pick the (data, length) overload
+			const std::string_view vertex {vertex_source};
+			const std::string_view fragment {fragment_source};
+
+			key = impl::hash(fragment, impl::hash(vertex, impl::hash(driver())));
+
+			if (load_binary()) {
+				key = 0;
+				return;
+			}
+
+			glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+		}
+
+		vert = compile_shader(GL_VERTEX_SHADER, vertex_source);
+		frag = compile_shader(GL_FRAGMENT_SHADER, fragment_source);
+
+		glAttachShader(program, vert);
+		glAttachShader(program, frag);
+		glLinkProgram(program);
 	}
 
 	Shader::~Shader() {
-		glDeleteProgram(program);
+		if (vert != 0) {
+			glDeleteShader(vert);
+			glDeleteShader(frag);
+		}
+
+		impl::GLState::deleteProgram(program);
+	}
+
+	bool Shader::ready() const {
+		if (vert != 0 && GLAD_GL_KHR_parallel_shader_compile) {
+			GLint completed = GL_FALSE;
+			glGetProgramiv(program, GL_COMPLETION_STATUS_KHR, &completed);
+			return completed == GL_TRUE;
+		}
+
+		return true;
 	}
 
 	void Shader::use() {
-		glUseProgram(program);
+		finalize();
+		impl::GLState::useProgram(program);
+	}
+
+	GLuint Shader::handle() const {
+		return program;
 	}
 
 	int Shader::uniform(const char* name) {
+		finalize();
 		return glGetUniformLocation(program, name);
 	}
 
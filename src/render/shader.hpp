@@ -8,19 +8,63 @@ namespace plgl {
 
 		private:
 
+			static std::string cache_directory;
+
 			GLuint program;
+			GLuint vert = 0, frag = 0;
+			uint64_t key = 0;
 
 			static GLuint compile_shader(GLenum type, const char* source);
-			static GLuint link_shader(GLuint vertex, GLuint fragment);
+			static void check_shader(GLuint shader);
+			static void check_program(GLuint program);
+
+			/// Get the driver identification string, used to invalidate cached binaries
+			static const std::string& driver();
+
+			std::string path() const;
+			bool load_binary();
+			void save_binary();
+
+			/// Wait for the program to be linked and check for errors
+			void finalize();
 
 		public:
 
+			/**
+			 * @brief Enable program binary cache
+			 *
+			 * Linked programs will be stored in the given directory and reused
+			 * on subsequent runs, skipping GLSL compilation. Cached binaries are keyed by
+			 * the shader source and the driver string, so updating either discards them.
+			 * Pass an empty string to disable the cache.
+			 *
+			 * @param[in] path Path to the cache directory, it will be created if needed
+			 */
+			static void cache(const std::string& path);
+
+			/**
+			 * @brief Enable parallel shader compilation
+			 *
+			 * Allows the driver to compile shaders on background threads
+			 * if KHR_parallel_shader_compile is supported. Shaders are then only waited for
+			 * when first used, this is invoked by plgl::open() automatically.
+			 *
+			 * @return True if the extension is supported
+			 */
+			static bool parallel();
+
 			Shader(const char* vertex_source, const char* fragment_source);
 			~Shader();
 
+			/// Check if the program is ready, never blocks when parallel compilation is enabled
+			bool ready() const;
+
 			/// Bind this OpenGL Shader
 			void use();
 
+			/// Get OpenGL program handle
+			GLuint handle() const;
+
 			/// Get OpenGL uniform location
 			int uniform(const char* name);
 
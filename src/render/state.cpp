@@ -0,0 +1,185 @@
+
+#include "state.hpp"
+
+namespace plgl::impl {
+
+	// marks state that is not known, and so must always be set
+	static constexpr GLuint unknown = 0xFFFFFFFF;
+
+	GLuint GLState::program = unknown;
+	GLuint GLState::vertex_array = unknown;
+	GLuint GLState::array_buffer = unknown;
+	GLuint GLState::unpack_buffer = unknown;
+	GLuint GLState::read_framebuffer = unknown;
+	GLuint GLState::draw_framebuffer = unknown;
+	GLenum GLState::active_unit = unknown;
+	GLuint GLState::textures[units][targets];
+	bool GLState::depth_mask = true;
+
+	size_t GLState::skipped_count = 0;
+	size_t GLState::issued_count = 0;
+
+	/*
+	 * GLState
+	 */
+
+	GLuint* GLState::buffer(GLenum target) {
+		if (target == GL_ARRAY_BUFFER) return &array_buffer;
+		if (target == GL_PIXEL_UNPACK_BUFFER) return &unpack_buffer;
+
+		return nullptr;
+	}
+
+	int GLState::index(GLenum target) {
+		if (target == GL_TEXTURE_2D) return 0;
+		if (target == GL_TEXTURE_2D_ARRAY) return 1;
+
+		return -1;
+	}
+
+	bool GLState::skip(bool redundant) {
+		if (redundant) {
+			skipped_count ++;
+			return true;
+		}
+
+		issued_count ++;
+		return false;
+	}
+
+	void GLState::useProgram(GLuint program) {
+		if (!skip(GLState::program == program)) {
+			glUseProgram(program);
+			GLState::program = program;
+		}
+	}
+
+	void GLState::bindVertexArray(GLuint vao) {
+		if (!skip(vertex_array == vao)) {
+			glBindVertexArray(vao);
+			vertex_array = vao;
+		}
+	}
+
+	void GLState::bindBuffer(GLenum target, GLuint buffer) {
+		GLuint* cached = GLState::buffer(target);
+
+		if (cached == nullptr) {
+			issued_count ++;
+			glBindBuffer(target, buffer);
+			return;
+		}
+
+		if (!skip(*cached == buffer)) {
+			glBindBuffer(target, buffer);
+			*cached = buffer;
+		}
+	}
+
+	void GLState::bindFramebuffer(GLenum target, GLuint fbo) {
+		bool read = (target == GL_FRAMEBUFFER || target == GL_READ_FRAMEBUFFER);
+		bool draw = (target == GL_FRAMEBUFFER || target == GL_DRAW_FRAMEBUFFER);
+
+		if (!skip((!read || read_framebuffer == fbo) && (!draw || draw_framebuffer == fbo))) {
+			glBindFramebuffer(target, fbo);
+
+			if (read) read_framebuffer = fbo;
+			if (draw) draw_framebuffer = fbo;
+		}
+	}
+
+	void GLState::bindTexture(GLenum target, GLuint texture, int unit) {
+		int slot = index(target);
+
+		if (unit >= units || slot == -1) {
+			issued_count ++;
+			glActiveTexture(GL_TEXTURE0 + unit);
+			glBindTexture(target, texture);
+			active_unit = GL_TEXTURE0 + unit;
+			return;
+		}
+
+		const GLenum selected = GL_TEXTURE0 + unit;
+
+		// the unit is selected even if the binding is skipped, as the
+		// caller may follow up with calls that modify the bound texture
+		if (active_unit != selected) {
+			glActiveTexture(selected);
+			active_unit = selected;
+		}
+
+		if (skip(textures[unit][slot] == texture)) {
+			return;
+		}
+
+		glBindTexture(target, texture);
+		textures[unit][slot] = texture;
+	}
+
+	void GLState::depthMask(bool mask) {
+		if (!skip(depth_mask == mask)) {
+			glDepthMask(mask);
+			depth_mask = mask;
+		}
+	}
+
+	void GLState::deleteProgram(GLuint program) {
+		if (GLState::program == program) GLState::program = 0;
+		glDeleteProgram(program);
+	}
+
+	void GLState::deleteVertexArray(GLuint vao) {
+		if (vertex_array == vao) vertex_array = 0;
+		glDeleteVertexArrays(1, &vao);
+	}
+
+	void GLState::deleteBuffer(GLuint buffer) {
+		if (array_buffer == buffer) array_buffer = 0;
+		if (unpack_buffer == buffer) unpack_buffer = 0;
+		glDeleteBuffers(1, &buffer);
+	}
+
+	void GLState::deleteFramebuffer(GLuint fbo) {
+		if (read_framebuffer == fbo) read_framebuffer = 0;
+		if (draw_framebuffer == fbo) draw_framebuffer = 0;
+		glDeleteFramebuffers(1, &fbo);
+	}
+
+	void GLState::deleteTexture(GLuint texture) {
+		for (auto& unit : textures) {
+			for (GLuint& bound : unit) {
+				if (bound == texture) bound = 0;
+			}
+		}
+
+		glDeleteTextures(1, &texture);
+	}
+
+	void GLState::invalidate() {
+		program = unknown;
+		vertex_array = unknown;
+		array_buffer = unknown;
+		unpack_buffer = unknown;
+		read_framebuffer = unknown;
+		draw_framebuffer = unknown;
+		active_unit = unknown;
+
+		for (auto& unit : textures) {
+			for (GLuint& bound : unit) {
+				bound = unknown;
+			}
+		}
+
+		glDepthMask(GL_TRUE);
+		depth_mask = true;
+	}
+
+	size_t GLState::skipped() {
+		return skipped_count;
+	}
+
+	size_t GLState::issued() {
+		return issued_count;
+	}
+
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "external.hpp"
+
+namespace plgl::impl {
+
+	/**
+	 * Shadow copy of the OpenGL binding state, all binds done by the
+	 * renderer go through here so that redundant state changes can be skipped.
+	 * Objects must also be deleted through this class so that
+	 * no stale handles stay cached.
+	 */
+	class GLState {
+
+		private:
+
+			static constexpr int units = 8;
+			static constexpr int targets = 2;
+
+			static GLuint program;
+			static GLuint vertex_array;
+			static GLuint array_buffer;
+			static GLuint unpack_buffer;
+			static GLuint read_framebuffer;
+			static GLuint draw_framebuffer;
+			static GLenum active_unit;
+			static GLuint textures[units][targets];
+			static bool depth_mask;
+
+			static size_t skipped_count;
+			static size_t issued_count;
+
+			static GLuint* buffer(GLenum target);
+			static int index(GLenum target);
+			static bool skip(bool redundant);
+
+		public:
+
+			static void useProgram(GLuint program);
+			static void bindVertexArray(GLuint vao);
+			static void bindBuffer(GLenum target, GLuint buffer);
+			static void bindFramebuffer(GLenum target, GLuint fbo);
+			static void bindTexture(GLenum target, GLuint texture, int unit = 0);
+			static void depthMask(bool mask);
+
+			static void deleteProgram(GLuint program);
+			static void deleteVertexArray(GLuint vao);
+			static void deleteBuffer(GLuint buffer);
+			static void deleteFramebuffer(GLuint fbo);
+			static void deleteTexture(GLuint texture);
+
+			/// Forget all cached state, must be called if the state was changed externally
+			static void invalidate();
+
+			/// Number of state changes skipped as redundant
+			static size_t skipped();
+
+			/// Number of state changes that were passed to OpenGL
+			static size_t issued();
+
+	};
+
+}
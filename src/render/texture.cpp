@@ -1,6 +1,10 @@
 
 #include "texture.hpp"
 #include "internal.hpp"
+#include "state.hpp"
+#include "atlas.hpp"
+#include "ops.hpp"
+#include "loader.hpp"
 
 namespace plgl {
 
@@ -12,68 +16,329 @@ namespace plgl {
 		// do nothing
 	}
 
+	bool PixelBuffer::layered() const {
+		return false;
+	}
+
+	/*
+	 * Sprite
+	 */
+
+	Sprite::Sprite(Texture* texture, int x, int y, int w, int h, int layer)
+	: texture(texture), x(x), y(y), w(w), h(h), layer(layer) {}
+
+	bool Sprite::opaque() const {
+		if (solid == -1) {
+			auto* atlas = dynamic_cast<Atlas*>(texture);
+
+			// only needed for depth sorting, so it's not worth checking the pixels on every submit
+			if (atlas) {
+				solid = atlas->getImage(layer).view(x, y, w, h).opaque();
+			} else {
+				solid = texture && texture->opaque();
+			}
+		}
+
+		return solid;
+	}
+
 	/*
 	 * Texture
 	 */
 
+	ankerl::unordered_dense::map<GLuint, uint64_t> Texture::uploads;
+	uint64_t Texture::serial = 0;
+
 	GLenum Texture::format(int channels) {
 		switch (channels) {
 			case 4: return GL_RGBA;
 			case 3: return GL_RGB;
 			case 2: return GL_RG;
-			case 1: return GL_ALPHA;
+			case 1: return GL_RED;
+		}
+
+		fault("Unsupported texture channel count: {}!", channels);
+	}
+
+	GLenum Texture::internal(int channels) {
+		switch (channels) {
+			case 4: return GL_RGBA8;
+			case 3: return GL_RGB8;
+			case 2: return GL_RG8;
+			case 1: return GL_R8;
 		}
 
 		fault("Unsupported texture channel count: {}!", channels);
 	}
 
-	void Texture::upload(const void* data, int width, int height, int channels) {
-		glBindTexture(GL_TEXTURE_2D, tid);
+	void Texture::swizzle(int channels) {
 
-		// upload texture data
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, format(channels), GL_UNSIGNED_BYTE, data);
-		glGenerateMipmap(GL_TEXTURE_2D);
+		// make smaller formats look like the images they came from, grey (1) and grey with alpha (2)
+		static const GLint grey[4] = {GL_RED, GL_RED, GL_RED, GL_ONE};
+		static const GLint grey_alpha[4] = {GL_RED, GL_RED, GL_RED, GL_GREEN};
+		static const GLint color[4] = {GL_RED, GL_GREEN, GL_BLUE, GL_ALPHA};
 
-		this->c = channels;
-		this->w = width;
-		this->h = height;
+		const GLint* mask = (channels == 1) ? grey : (channels == 2) ? grey_alpha : color;
+		glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, mask);
 	}
 
-	Texture::Texture() {
-		glGenTextures(1, &tid);
-		glBindTexture(GL_TEXTURE_2D, tid);
+	void Texture::transfer(int level, const ImageView& image) {
+		const int channels = image.channels();
+
+		// views into bigger images are read in place, GL skips the rest of each row
+		const bool packed = image.stride() % channels == 0;
+		glPixelStorei(GL_UNPACK_ROW_LENGTH, packed ? image.stride() / channels : 0);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
 
-		// set texture wrapping
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+		if (packed || image.contiguous()) {
+			glTexImage2D(GL_TEXTURE_2D, level, internal(channels), image.width(), image.height(), 0, format(channels), GL_UNSIGNED_BYTE, image.row(0));
+		} else {
+			glTexImage2D(GL_TEXTURE_2D, level, internal(channels), image.width(), image.height(), 0, format(channels), GL_UNSIGNED_BYTE, nullptr);
 
-		// set texture filtering
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+			for (size_t y = 0; y < image.height(); y ++) {
+				glTexSubImage2D(GL_TEXTURE_2D, level, 0, y, image.width(), 1, format(channels), GL_UNSIGNED_BYTE, image.row(y));
+			}
+		}
+
+		glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+		if (level == 0) {
+			swizzle(channels);
+		}
 	}
 
-	Texture::Texture(const char* path)
-	: Texture() {
-		Image image = Image::load(path);
+	void Texture::apply() {
+		if (!tid) {
+			return;
+		}
+
+		const GLenum target = layered() ? GL_TEXTURE_2D_ARRAY : GL_TEXTURE_2D;
+		impl::GLState::bindTexture(target, tid);
+
+		static const GLint wraps[] = {GL_REPEAT, GL_CLAMP_TO_EDGE, GL_MIRRORED_REPEAT};
+		glTexParameteri(target, GL_TEXTURE_WRAP_S, wraps[sampling.wrap]);
+		glTexParameteri(target, GL_TEXTURE_WRAP_T, wraps[sampling.wrap]);
+
+		const bool nearest = (sampling.filter == Sampler::NEAREST);
+		GLint minify = nearest ? GL_NEAREST : GL_LINEAR;
+
+		if (sampling.mipmaps != Sampler::NONE) {
+			minify = nearest ? GL_NEAREST_MIPMAP_NEAREST : GL_LINEAR_MIPMAP_LINEAR;
+		}
+
+		glTexParameteri(target, GL_TEXTURE_MIN_FILTER, minify);
+		glTexParameteri(target, GL_TEXTURE_MAG_FILTER, nearest ? GL_NEAREST : GL_LINEAR);
+
+		if (GLAD_GL_VERSION_4_6 || GLAD_GL_ARB_texture_filter_anisotropic || GLAD_GL_EXT_texture_filter_anisotropic) {
+			static const float limit = [] () {
+				float value = 1;
+				glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &value);
+				return value;
+			} ();
+
+			glTexParameterf(target, GL_TEXTURE_MAX_ANISOTROPY_EXT, std::clamp(sampling.anisotropy, 1.0f, limit));
+		}
+	}
+
+	void Texture::mipmap(const ImageView& image) {
+		const uint64_t upload = ++ serial;
+		uploads[tid] = upload;
+
+		if (sampling.mipmaps == Sampler::NONE) {
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+			return;
+		}
+
+		if (sampling.mipmaps == Sampler::GPU || loader == nullptr) {
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 1000);
+			glGenerateMipmap(GL_TEXTURE_2D);
+			return;
+		}
+
+		// only the full size image is sampled until the levels arrive
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+
+		// the view is only valid during this call, so the worker gets its own copy
+		auto base = std::make_shared<Image>(Image::allocate(image.width(), image.height(), image.channels()));
+		base->blit(0, 0, image);
+
+		loader->schedule<std::vector<Image>>([base] () {
+			std::vector<Image> levels;
+			ImageView previous = base->view();
+
+			// each level is filtered down from the one before it
+			for (int w = base->width(), h = base->height(); w > 1 || h > 1; ) {
+				w = std::max(1, w / 2);
+				h = std::max(1, h / 2);
+
+				levels.push_back(ops::resize(previous, w, h, ops::LANCZOS));
+				previous = levels.back().view();
+			}
+
+			return levels;
+		}, [tid = this->tid, upload] (std::vector<Image>& levels) {
+
+			// the texture was closed or something else was uploaded into it in the meantime
+			auto it = uploads.find(tid);
+
+			if (it == uploads.end() || it->second != upload) {
+				return;
+			}
+
+			impl::GLState::bindTexture(GL_TEXTURE_2D, tid);
+
+			for (size_t i = 0; i < levels.size(); i ++) {
+				transfer(i + 1, levels[i]);
+			}
+
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels.size());
+		}, false);
+	}
+
+	bool Texture::atlased(const Sampler& sampler) {
+
+		// the atlas has no mip levels, is always sampled with linear filtering,
+		// and can't repeat a sprite without sampling its neighbours
+		return sampler.mipmaps == Sampler::NONE && sampler.filter == Sampler::LINEAR && sampler.wrap == Sampler::CLAMP;
+	}
+
+	void Texture::create() {
+		glGenTextures(1, &tid);
+		apply();
+	}
+
+	Texture::Texture() {
+		create();
+	}
+
+	void Texture::load(const ImageView& image) {
+
+		// small textures share one GL texture so that they can be batched
+		if (atlased(sampling) && impl::TextureAtlas::accepts(image)) {
+			close();
+
+			this->region = impl::TextureAtlas::submit(image);
+			this->c = image.channels();
+			this->w = image.width();
+			this->h = image.height();
+			this->solid = -1;
+			return;
+		}
+
 		upload(image);
-		image.close();
+	}
+
+	void Texture::load(const TextureFile& file) {
+		const ImageView& image = file.level(0);
+
+		// stored mip levels are only used if mip levels were requested
+		if (file.levels() == 1 || sampling.mipmaps == Sampler::NONE) {
+			load(image);
+			return;
+		}
+
+		if (!tid) {
+			create();
+			region = {};
+		}
+
+		impl::GLState::bindTexture(GL_TEXTURE_2D, tid);
+
+		for (int i = 0; i < file.levels(); i ++) {
+			transfer(i, file.level(i));
+		}
+
+		uploads[tid] = ++ serial;
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, file.levels() - 1);
+
+		this->c = image.channels();
+		this->w = image.width();
+		this->h = image.height();
+		this->solid = -1;
+	}
+
+	Texture::Texture(const char* path, const Sampler& sampler)
+	: sampling(sampler) {
+		load(impl::TextureCache::load(path));
 	}
 
 	void Texture::close() {
-		glDeleteTextures(1, &tid);
+		if (tid) {
+			uploads.erase(tid);
+			impl::GLState::deleteTexture(tid);
+			tid = 0;
+		}
 	}
 
-	void Texture::use() const {
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, tid);
+	void Texture::use() {
+		if (region.texture) {
+			region.texture->use();
+			return;
+		}
+
+		impl::GLState::bindTexture(GL_TEXTURE_2D, tid);
+	}
+
+	void Texture::upload(const ImageView& image) {
+		if (!tid) {
+			create();
+			region = {};
+		}
+
+		impl::GLState::bindTexture(GL_TEXTURE_2D, tid);
+		transfer(0, image);
+		mipmap(image);
+
+		this->c = image.channels();
+		this->w = image.width();
+		this->h = image.height();
+		this->solid = -1;
 	}
 
-	void Texture::upload(Image& image) {
-		upload(image.data(), image.width(), image.height(), image.channels());
+	const Sprite& Texture::sprite() const {
+		return region;
+	}
+
+	void Texture::sampler(const Sampler& sampler) {
+
+		// the atlas can't honour this sampler, so the texture moves out into its own GL texture
+		if (region.texture && !atlased(sampler)) {
+			Image image = pixels();
+			sampling = sampler;
+			upload(image);
+			image.close();
+			return;
+		}
+
+		const bool generate = (sampling.mipmaps == Sampler::NONE && sampler.mipmaps != Sampler::NONE);
+		sampling = sampler;
+		apply();
+
+		// only plain textures have mip levels, not the atlas nor textures placed in it
+		if (!generate || !tid || w == 0 || layered()) {
+			return;
+		}
+
+		if (sampling.mipmaps == Sampler::CPU) {
+			Image image = pixels();
+			impl::GLState::bindTexture(GL_TEXTURE_2D, tid);
+			mipmap(image);
+		} else {
+			mipmap({});
+		}
+	}
+
+	const Sampler& Texture::sampler() const {
+		return sampling;
 	}
 
 	int Texture::handle() const {
-		return tid;
+		return region.texture ? region.texture->handle() : tid;
+	}
+
+	bool Texture::layered() const {
+		return region.texture != nullptr;
 	}
 
 	int Texture::width() const {
@@ -84,10 +349,28 @@ namespace plgl {
 		return h;
 	}
 
+	bool Texture::opaque() const {
+		if (solid == -1) {
+			solid = region.texture ? region.opaque() : pixels().opaque();
+		}
+
+		return solid;
+	}
+
 	Image Texture::pixels() const {
 		Image image = Image::allocate(w, h, c);
-		glBindTexture(GL_TEXTURE_2D, tid);
-		glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, image.data());
+
+		// atlased textures are copied out of the atlas pages
+		if (region.texture) {
+			const Image& page = ((Atlas*) region.texture)->getImage(region.layer);
+			image.blit(0, 0, page.view(region.x, region.y, w, h));
+			return image;
+		}
+
+		impl::GLState::bindTexture(GL_TEXTURE_2D, tid);
+		glPixelStorei(GL_PACK_ALIGNMENT, 1);
+		glGetTexImage(GL_TEXTURE_2D, 0, format(c), GL_UNSIGNED_BYTE, image.data());
+		glPixelStorei(GL_PACK_ALIGNMENT, 4);
 		return image;
 	}
 
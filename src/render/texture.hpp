@@ -2,6 +2,7 @@
 
 #include "external.hpp"
 #include "image.hpp"
+#include "cache.hpp"
 
 namespace plgl {
 
@@ -11,36 +12,129 @@ namespace plgl {
 
 			virtual ~PixelBuffer();
 
-			virtual void use() const = 0;
+			virtual void use() = 0;
 			virtual int handle() const = 0;
 			virtual int width() const = 0;
 			virtual int height() const = 0;
 
+			/// Check if this is an array texture, sampled using the layer vertex coordinate
+			virtual bool layered() const;
+
+	};
+
+	class Texture;
+	class Loader;
+
+	struct Sprite {
+
+		Texture* texture = nullptr;
+		int x, y, w, h;
+		int layer = 0;
+
+		Sprite() = default;
+		Sprite(Texture* texture, int x, int y, int w, int h, int layer = 0);
+
+		/// Check if every pixel of the sprite is fully opaque, scanned on first use
+		bool opaque() const;
+
+		private:
+
+			// -1 until the pixels are checked
+			mutable int8_t solid = -1;
+
+	};
+
+	/**
+	 * Describes how a texture is sampled, mip levels are only
+	 * created if requested, as they cost both memory and upload time
+	 */
+	struct Sampler {
+
+		enum Filter {
+			NEAREST, ///< Use the closest texel, for pixel art
+			LINEAR   ///< Interpolate between texels
+		};
+
+		enum Wrap {
+			REPEAT, ///< Tile the texture
+			CLAMP,  ///< Repeat the edge texels
+			MIRROR  ///< Tile the texture, flipping every other copy
+		};
+
+		enum Mipmaps {
+			NONE, ///< No mip levels, minified textures can alias
+			GPU,  ///< Mip levels generated by the driver during upload
+			CPU   ///< Mip levels computed with a high quality filter on a worker thread, the full size image is used until they are ready
+		};
+
+		Filter filter = LINEAR;
+		Wrap wrap = REPEAT;
+		Mipmaps mipmaps = NONE;
+
+		/// Maximum anisotropy, values above 1 only have an effect on mipmapped textures, clamped to what the driver supports
+		float anisotropy = 1;
+
 	};
 
 	class Texture : public PixelBuffer {
 
 		protected:
 
-			GLuint tid;
-			int c, w, h;
+			GLuint tid = 0;
+			int c = 0, w = 0, h = 0;
+			// -1 while the uploaded pixels were not yet checked, see opaque()
+			mutable int8_t solid = 0;
+			Sampler sampling;
+
+			// last upload of each texture, used to drop mip levels that were computed for an older image
+			static ankerl::unordered_dense::map<GLuint, uint64_t> uploads;
+			static uint64_t serial;
+
+			// location in the shared atlas, if this texture was placed in one
+			Sprite region;
+
+			friend class Loader;
 
 			static GLenum format(int channels);
-			void upload(const void* data, int width, int height, int channels);
+			static GLenum internal(int channels);
+			static void swizzle(int channels);
+			static void transfer(int level, const ImageView& image);
+			static bool atlased(const Sampler& sampler);
+			void apply();
+			void mipmap(const ImageView& image);
+			void create();
+			void load(const ImageView& image);
+			void load(const TextureFile& file);
 
 		public:
 
 			Texture();
-			Texture(const char* path);
+			Texture(const char* path, const Sampler& sampler = {});
 
 			/// Free resources associated with this texture
 			void close();
 
-			/// Upload an image into this Texture
-			void upload(Image& image);
+			/// Upload an image (or a part of one) into this Texture, moves the texture out of the shared atlas
+			void upload(const ImageView& image);
+
+			/// Get the area of the shared atlas this texture uses, sprite().texture is null if there is none
+			const Sprite& sprite() const;
+
+			/**
+			 * @brief Change sampling parameters.
+			 *
+			 * If mip levels were not requested before they are created now, for CPU mip
+			 * levels this reads the texture back, so prefer passing the sampler to the constructor.
+			 * Textures in the shared atlas can only use linear filtering and clamping without mip levels,
+			 * any other sampler moves the texture out of the atlas into its own GL texture.
+			 */
+			void sampler(const Sampler& sampler);
+
+			/// Get the current sampling parameters
+			const Sampler& sampler() const;
 
 			/// Bind this OpenGL Texture
-			void use() const override;
+			void use() override;
 
 			/// Get OpenGL Texture handle
 			int handle() const override;
@@ -51,6 +145,11 @@ namespace plgl {
 			/// Get image height in pixels
 			int height() const override;
 
+			bool layered() const override;
+
+			/// Check if every pixel of the last uploaded image was fully opaque, scanned on first use
+			bool opaque() const;
+
 			/// Copy image from from Texture into a Image buffer
 			Image pixels() const;
 
@@ -0,0 +1,295 @@
+
+#include "tiled.hpp"
+#include "renderer.hpp"
+#include "state.hpp"
+#include "ops.hpp"
+#include "pool.hpp"
+#include "loader.hpp"
+#include "globals.hpp"
+
+namespace plgl {
+
+	/*
+	 * TiledImage::Pool
+	 */
+
+	TiledImage::Pool::Pool(int size, int layers)
+	: size(size), layers(layers) {
+
+		// the texture created by the Texture constructor is not an array
+		impl::GLState::deleteTexture(tid);
+		glGenTextures(1, &tid);
+
+		this->c = 4;
+		this->w = size;
+		this->h = size;
+		this->sampling.wrap = Sampler::CLAMP;
+
+		apply();
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, 0);
+
+		if (GLAD_GL_VERSION_4_2 || GLAD_GL_ARB_texture_storage) {
+			glTexStorage3D(GL_TEXTURE_2D_ARRAY, 1, GL_RGBA8, size, size, layers);
+		} else {
+			glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, size, size, layers, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+		}
+	}
+
+	void TiledImage::Pool::use() {
+		impl::GLState::bindTexture(GL_TEXTURE_2D_ARRAY, tid);
+	}
+
+	int TiledImage::Pool::width() const {
+		return size;
+	}
+
+	int TiledImage::Pool::height() const {
+		return size;
+	}
+
+	bool TiledImage::Pool::layered() const {
+		return true;
+	}
+
+	/*
+	 * TiledImage
+	 */
+
+	uint64_t TiledImage::key(int level, int x, int y) {
+		return ((uint64_t) level << 56) | ((uint64_t) x << 28) | (uint64_t) y;
+	}
+
+	int TiledImage::columns(int level) const {
+		return (source->level(level).width() + content - 1) / content;
+	}
+
+	int TiledImage::rows(int level) const {
+		return (source->level(level).height() + content - 1) / content;
+	}
+
+	const TiledImage::Tile* TiledImage::find(int level, int x, int y) {
+		auto it = resident.find(key(level, x, y));
+
+		if (it == resident.end()) {
+			return nullptr;
+		}
+
+		// mark as recently used
+		tiles.splice(tiles.begin(), tiles, it->second);
+		it->second->frame = frame_count;
+
+		return &*it->second;
+	}
+
+	void TiledImage::request(int level, int x, int y) {
+		const uint64_t id = key(level, x, y);
+
+		// don't flood the workers, the rest is requested during the next frames
+		if (pending.contains(id) || (int) pending.size() >= impl::ThreadPool::get().size() * 2) {
+			return;
+		}
+
+		pending.insert(id);
+
+		auto work = [source = this->source, level, x, y, tile = this->tile, content = this->content] () {
+			const ImageView& view = source->level(level);
+			const int c = view.channels();
+			const int width = view.width();
+
+			Image image = Image::allocate(tile, tile, c);
+
+			const int ox = x * content - border;
+			const int oy = y * content - border;
+
+			// the part of the tile that lies inside the image, the rest repeats the edge pixels
+			const int begin = std::clamp(-ox, 0, tile);
+			const int end = std::clamp(width - ox, begin, tile);
+
+			for (int j = 0; j < tile; j ++) {
+				const uint8_t* input = view.row(std::clamp(oy + j, 0, (int) view.height() - 1));
+				uint8_t* output = image.pixel(0, j).data();
+
+				memcpy(output + begin * c, input + (ox + begin) * c, (end - begin) * c);
+
+				for (int i = 0; i < begin; i ++) {
+					memcpy(output + i * c, input, c);
+				}
+
+				for (int i = end; i < tile; i ++) {
+					memcpy(output + i * c, input + (width - 1) * c, c);
+				}
+			}
+
+			return (c == 4) ? std::move(image) : ops::convert(image, 4);
+		};
+
+		loader->schedule<Image>(work, [this, alive = this->alive, id] (Image& image) {
+			if (*alive) {
+				pending.erase(id);
+				store(id, image);
+			}
+		}, false);
+	}
+
+	void TiledImage::store(uint64_t key, const Image& image) {
+		if (!pool) {
+			return;
+		}
+
+		int layer = tiles.size();
+
+		// replace the least recently drawn tile, unless it is still on screen
+		if (layer >= pool->layers) {
+			Tile& oldest = tiles.back();
+
+			if (oldest.frame == frame_count) {
+				return;
+			}
+
+			layer = oldest.layer;
+			resident.erase(oldest.key);
+			tiles.pop_back();
+		}
+
+		impl::GLState::bindTexture(GL_TEXTURE_2D_ARRAY, pool->handle());
+		glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, tile, tile, 1, GL_RGBA, GL_UNSIGNED_BYTE, image.data());
+
+		tiles.push_front({key, layer, frame_count});
+		resident[key] = tiles.begin();
+	}
+
+	TiledImage::TiledImage(const std::string& path, size_t budget, int tile)
+	: alive(std::make_shared<bool>(true)), tile(tile), content(tile - 2 * border), budget(budget) {
+
+		if (content <= 0) {
+			fault("Tile size of {} is too small!", tile);
+		}
+
+		// the whole mip chain is needed, coarse levels are drawn while the finer ones load
+		loader->schedule<TextureFile>([path] () {
+			TextureFile file = impl::TextureCache::load(path, true);
+			file.prefetch();
+			return file;
+		}, [this, alive = this->alive] (TextureFile& file) {
+			if (*alive) {
+				source = std::make_shared<TextureFile>(std::move(file));
+			}
+		});
+	}
+
+	TiledImage::~TiledImage() {
+		*alive = false;
+		close();
+	}
+
+	void TiledImage::close() {
+		if (pool) {
+			pool->close();
+			delete pool;
+			pool = nullptr;
+		}
+
+		tiles.clear();
+		resident.clear();
+	}
+
+	bool TiledImage::ready() const {
+		return source != nullptr;
+	}
+
+	int TiledImage::width() const {
+		return source ? source->level(0).width() : 0;
+	}
+
+	int TiledImage::height() const {
+		return source ? source->level(0).height() : 0;
+	}
+
+	size_t TiledImage::uploaded() const {
+		return tiles.size();
+	}
+
+	void TiledImage::draw(float x, float y, float w, float h) {
+		if (!source || w <= 0 || h <= 0) {
+			return;
+		}
+
+		if (!pool) {
+			GLint limit = 256;
+			glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &limit);
+			pool = new Pool(tile, std::clamp<long>(budget / ((size_t) tile * tile * 4), 1, limit));
+		}
+
+		// the finest level that is not smaller than the image on screen
+		const int levels = source->levels();
+		const float scale = std::max(width() / w, height() / h);
+		const int level = scale > 1 ? std::clamp((int) std::floor(std::log2(scale)), 0, levels - 1) : 0;
+
+		const ImageView& view = source->level(level);
+		const float sx = w / view.width();
+		const float sy = h / view.height();
+		const float cx = content * sx;
+		const float cy = content * sy;
+
+		// only the tiles that overlap the window, tile rows grow upwards from 'y'
+		const int x0 = std::max(0, (int) std::floor(-x / cx));
+		const int x1 = std::min(columns(level), (int) std::floor((plgl::width - x) / cx) + 1);
+		const int y0 = std::max(0, (int) std::floor((y - plgl::height) / cy));
+		const int y1 = std::min(rows(level), (int) std::floor(y / cy) + 1);
+
+		for (int ty = y0; ty < y1; ty ++) {
+			for (int tx = x0; tx < x1; tx ++) {
+				const int tw = std::min(content, (int) view.width() - tx * content);
+				const int th = std::min(content, (int) view.height() - ty * content);
+
+				const float left = x + tx * cx;
+				const float bottom = y - ty * cy;
+
+				if (const Tile* found = find(level, tx, ty)) {
+					renderer->texture(*pool, border, border, border + tw, border + th, found->layer);
+					renderer->image(left, bottom, tw * sx, th * sy);
+					continue;
+				}
+
+				// draw the matching part of a coarser tile until this one is ready
+				for (int coarse = level + 1; coarse < levels; coarse ++) {
+					const ImageView& parent = source->level(coarse);
+					const float rx = parent.width() / (float) view.width();
+					const float ry = parent.height() / (float) view.height();
+
+					const float ax = tx * content * rx;
+					const float ay = ty * content * ry;
+					const int px = std::min((int) (ax / content), columns(coarse) - 1);
+					const int py = std::min((int) (ay / content), rows(coarse) - 1);
+
+					const Tile* found = find(coarse, px, py);
+
+					if (found == nullptr) {
+
+						// the last level always covers the area, so there is always something to draw
+						if (coarse == levels - 1) {
+							request(coarse, px, py);
+						}
+
+						continue;
+					}
+
+					const float u = border + ax - px * content;
+					const float v = border + ay - py * content;
+
+					// with odd level sizes the area can end slightly past the coarse tile, stretch the part that is inside
+					// instead of sampling the border and past the edge of the layer
+					const float u1 = std::min(u + tw * rx, (float) border + std::min(content, (int) parent.width() - px * content));
+					const float v1 = std::min(v + th * ry, (float) border + std::min(content, (int) parent.height() - py * content));
+
+					renderer->texture(*pool, u, v, u1, v1, found->layer);
+					renderer->image(left, bottom, tw * sx, th * sy);
+					break;
+				}
+
+				request(level, tx, ty);
+			}
+		}
+	}
+
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "external.hpp"
+#include "texture.hpp"
+#include "cache.hpp"
+
+namespace plgl {
+
+	/**
+	 * @brief Image too big to be kept on the GPU as a whole.
+	 *
+	 * The image, and its mip levels, are split into square tiles. Only the tiles that are visible
+	 * are uploaded, into a fixed size texture array, and the least recently drawn ones are replaced once it is full.
+	 * Tiles are read on worker threads, while a tile is missing a coarser level is drawn in its place. For images that
+	 * don't fit in memory enable plgl::texture_cache(), tiles are then read from the memory mapped cache file.
+	 *
+	 * @see plgl::image(TiledImage&, float, float, float, float)
+	 */
+	class TiledImage {
+
+		private:
+
+			// texture array holding the resident tiles, one per layer
+			class Pool : public Texture {
+
+				public:
+
+					int size;
+					int layers;
+
+					Pool(int size, int layers);
+
+					void use() override;
+					int width() const override;
+					int height() const override;
+					bool layered() const override;
+
+			};
+
+			struct Tile {
+				uint64_t key;
+				int layer;
+				long frame;
+			};
+
+			// one pixel of every tile is a copy of its neighbour, so that filtering doesn't show seams
+			static constexpr int border = 1;
+
+			std::shared_ptr<TextureFile> source;
+			std::shared_ptr<bool> alive;
+			Pool* pool = nullptr;
+
+			int tile;
+			int content;
+			size_t budget;
+
+			// resident tiles, most recently drawn at the front
+			std::list<Tile> tiles;
+			ankerl::unordered_dense::map<uint64_t, std::list<Tile>::iterator> resident;
+			ankerl::unordered_dense::set<uint64_t> pending;
+
+			static uint64_t key(int level, int x, int y);
+
+			int columns(int level) const;
+			int rows(int level) const;
+
+			const Tile* find(int level, int x, int y);
+			void request(int level, int x, int y);
+			void store(uint64_t key, const Image& image);
+
+		public:
+
+			/**
+			 * @brief Open tiled image
+			 *
+			 * The file is opened in the background, nothing is drawn until that is done.
+			 *
+			 * @param[in] path   Path of the image file
+			 * @param[in] budget Maximum amount of GPU memory, in bytes, to use for tiles
+			 * @param[in] tile   Width and height of the tiles in pixels
+			 */
+			TiledImage(const std::string& path, size_t budget = 256 * 1024 * 1024, int tile = 256);
+			~TiledImage();
+
+			TiledImage(const TiledImage& other) = delete;
+			TiledImage& operator = (const TiledImage& other) = delete;
+
+			/// Free the GPU memory, tiles are uploaded again when the image is next drawn
+			void close();
+
+			/// Check if the image file was opened
+			bool ready() const;
+
+			/// returns the width, in pixels, of the full resolution image
+			int width() const;
+
+			/// returns the height, in pixels, of the full resolution image
+			int height() const;
+
+			/// Number of tiles currently on the GPU
+			size_t uploaded() const;
+
+			/// Draw the visible part of the image, stretched to the given rectangle, at the level matching its size on screen
+			void draw(float x, float y, float w, float h);
+
+	};
+
+}
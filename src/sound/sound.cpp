@@ -11,11 +11,22 @@ namespace plgl {
 	 * Sound
 	 */
 
-	Sound::Sound(const std::string& path) {
+	Sound::Sound() {
+		this->handle = SoundSystem::get()->load();
+	}
 
-		SoundSystem* system = SoundSystem::get();
-		auto sound = system->load();
-		this->handle = sound;
+	void Sound::upload(const short* data, long count, int channels, int rate) {
+		if (std::shared_ptr<impl::SoundHandle> sound = handle.lock()) {
+			ALenum format = (channels > 1) ? AL_FORMAT_STEREO16 : AL_FORMAT_MONO16;
+			int length = count * channels * sizeof(uint16_t);
+
+			alBufferData(sound->id, format, data, length, rate);
+			impl::alCheckError("alBufferData");
+		}
+	}
+
+	Sound::Sound(const std::string& path)
+	: Sound() {
 
 		int channels;
 		int samples;
@@ -27,11 +38,7 @@ namespace plgl {
 			fault("Failed to load sound: '{}'!", path);
 		}
 
-		ALenum format = (channels > 1) ? AL_FORMAT_STEREO16 : AL_FORMAT_MONO16;
-		int length = count * channels * sizeof(uint16_t);
-
-		alBufferData(sound->id, format, data, length, samples);
-		impl::alCheckError("alBufferData");
+		upload(data, count, channels, samples);
 
 		// the documentation for STB vorbis is non-existent
 		// i assume this is what should be done, other STB libraries typically had a
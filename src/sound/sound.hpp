@@ -7,6 +7,7 @@
 namespace plgl {
 
 	class Source;
+	class Loader;
 
 	/**
 	 * Represents a loaded sound data (buffer), allows you to play a sound and then interact with it
@@ -46,6 +47,14 @@ namespace plgl {
 
 			std::weak_ptr<impl::SoundHandle> handle;
 
+			friend class Loader;
+
+			/// Create sound with an empty buffer, filled later by the Loader
+			Sound();
+
+			/// Fill the sound buffer with 16 bit samples
+			void upload(const short* data, long count, int channels, int rate);
+
 		public:
 
 			/**
@@ -1,45 +1,137 @@
-
 #include "utf8.hpp"
 
+#if defined(__SSE2__) || defined(_M_X64)
+#	include <emmintrin.h>
+#	define PLGL_SSE2
+#endif
+
 namespace plgl {
 
-	int next_unicode(const char* cstr, int* offset) {
+	/// Decode one sequence from at most 'size' bytes, returns the codepoint and saves the number of bytes used
+	static int decode_sequence(const unsigned char* ptr, size_t size, int* length) {
+		const unsigned char lead = *ptr;
+		int count, unicode, min;
 
-		const auto* ptr = reinterpret_cast<const unsigned char*>(cstr + *offset);
-
-		// this function can read past the end of the given string
-		// if it's invalidly formatted, but at most by 3 bytes
-		if (*ptr == 0) {
-			return 0;
-		}
+		*length = 1;
 
 		// 1-byte character: 0xxxxxxx
-		if (*ptr < 0x80) {
-			*offset += 1;
-			return *ptr;
+		if (lead < 0x80) {
+			return lead;
 		}
 
 		// 2-byte character: 110xxxxx 10xxxxxx
-		if ((*ptr & 0xE0) == 0xC0) {
-			*offset += 2;
-			return (*ptr & 0x1F) << 6 | (*(ptr + 1) & 0x3F);
-		}
+		if ((lead & 0xE0) == 0xC0) {
+			count = 2;
+			unicode = lead & 0x1F;
+			min = 0x80;
 
 		// 3-byte character: 1110xxxx 10xxxxxx 10xxxxxx
-		if ((*ptr & 0xF0) == 0xE0) {
-			*offset += 3;
-			return (*ptr & 0x0F) << 12 | (*(ptr + 1) & 0x3F) << 6 | (*(ptr + 2) & 0x3F);
-		}
+		} else if ((lead & 0xF0) == 0xE0) {
+			count = 3;
+			unicode = lead & 0x0F;
+			min = 0x800;
 
 		// 4-byte character: 11110xxx 10xxxxxx 10xxxxxx 10xxxxxx
-		if ((*ptr & 0xF8) == 0xF0) {
-			*offset += 4;
-			return (*ptr & 0x07) << 18 | (*(ptr + 1) & 0x3F) << 12 | (*(ptr + 2) & 0x3F) << 6 | (*(ptr + 3) & 0x3F);
+		} else if ((lead & 0xF8) == 0xF0) {
+			count = 4;
+			unicode = lead & 0x07;
+			min = 0x10000;
+
+		// stray continuation byte, or invalid lead byte
+		} else {
+			return unicode_replacement;
+		}
+
+		// each byte is checked before the next one is read, so a truncated
+		// sequence stops at the end of the buffer (or the null terminator)
+		for (int i = 1; i < count; i ++) {
+			if ((size_t) i >= size || (ptr[i] & 0xC0) != 0x80) {
+				*length = i;
+				return unicode_replacement;
+			}
+
+			unicode = (unicode << 6) | (ptr[i] & 0x3F);
+		}
+
+		*length = count;
+
+		// overlong encodings, UTF-16 surrogates, and values past the end of unicode
+		if (unicode < min || (unicode >= 0xD800 && unicode <= 0xDFFF) || unicode > 0x10FFFF) {
+			return unicode_replacement;
+		}
+
+		return unicode;
+	}
+
+	int next_unicode(const char* cstr, int* offset) {
+
+		const auto* ptr = reinterpret_cast<const unsigned char*>(cstr + *offset);
+
+		if (*ptr == 0) {
+			return 0;
 		}
 
-		// Invalid
-		*offset += 1;
-		return 0;
+		int length;
+		int unicode = decode_sequence(ptr, SIZE_MAX, &length);
+
+		*offset += length;
+		return unicode;
+	}
+
+	void decode_unicode(std::string_view text, std::vector<int>& codepoints) {
+
+		const auto* data = reinterpret_cast<const unsigned char*>(text.data());
+		const size_t size = text.size();
+		size_t offset = 0;
+
+		// there is at most one codepoint per byte
+		codepoints.reserve(codepoints.size() + size);
+
+		while (offset < size) {
+
+#ifdef PLGL_SSE2
+			const __m128i zero = _mm_setzero_si128();
+
+			// widen 16 bytes at a time while they are all ASCII, the whole block is
+			// always stored and the buffer is then cut to the ASCII prefix of the block
+			while (offset + 16 <= size) {
+				const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + offset));
+				const int mask = _mm_movemask_epi8(bytes);
+				const size_t ascii = (mask == 0) ? 16 : std::countr_zero((unsigned) mask);
+
+				if (ascii == 0) {
+					break;
+				}
+
+				const size_t at = codepoints.size();
+				codepoints.resize(at + 16);
+
+				const __m128i low = _mm_unpacklo_epi8(bytes, zero);
+				const __m128i high = _mm_unpackhi_epi8(bytes, zero);
+				auto* output = reinterpret_cast<__m128i*>(codepoints.data() + at);
+
+				_mm_storeu_si128(output + 0, _mm_unpacklo_epi16(low, zero));
+				_mm_storeu_si128(output + 1, _mm_unpackhi_epi16(low, zero));
+				_mm_storeu_si128(output + 2, _mm_unpacklo_epi16(high, zero));
+				_mm_storeu_si128(output + 3, _mm_unpackhi_epi16(high, zero));
+
+				codepoints.resize(at + ascii);
+				offset += ascii;
+
+				if (ascii != 16) {
+					break;
+				}
+			}
+
+			if (offset >= size) {
+				break;
+			}
+#endif
+
+			int length;
+			codepoints.push_back(decode_sequence(data + offset, size - offset, &length));
+			offset += length;
+		}
 	}
 
-}
\ No newline at end of file
+}
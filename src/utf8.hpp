@@ -4,17 +4,32 @@
 
 namespace plgl {
 
+	/// Codepoint used in place of invalid UTF-8 sequences
+	static constexpr int unicode_replacement = 0xFFFD;
+
 	/**
 	 * @brief Read unicode from string
 	 *
 	 * Reads between 1 and 4 bytes from the given utf-8 string and returns the corresponding unicode
 	 * codepoint as 32 bit integer. The Index into the string is read from, and saved to, given offset pointer.
+	 * Invalid sequences are returned as U+FFFD, and reading never goes past the null terminator.
 	 *
 	 * @param[in]     cstr    UTF-8 encoded c-string
 	 * @param[in,out] offset  Pointer to an offset into the string
 	 *
-	 * @return Unicode codepoint as 32 bit integer
+	 * @return Unicode codepoint as 32 bit integer, 0 at the end of the string
 	 */
 	int next_unicode(const char* cstr, int* offset);
 
-}
\ No newline at end of file
+	/**
+	 * @brief Decode the whole string
+	 *
+	 * Appends the unicode codepoints of the given utf-8 string to the buffer, invalid sequences are
+	 * decoded as U+FFFD. Runs of ASCII characters are converted 16 at a time where SSE2 is available.
+	 *
+	 * @param[in]  text        UTF-8 encoded string, doesn't need to be null terminated
+	 * @param[out] codepoints  Buffer the codepoints are appended to
+	 */
+	void decode_unicode(std::string_view text, std::vector<int>& codepoints);
+
+}
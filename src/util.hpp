@@ -109,6 +109,26 @@ namespace plgl {
 		throw std::runtime_error {format(format_string, args...)};
 	}
 
+	namespace impl {
+
+		/// 64 bit FNV-1a hash, used to derive stable on-disk cache keys
+		inline uint64_t hash(const void* data, size_t length, uint64_t seed = 0xcbf29ce484222325) {
+			const auto* bytes = static_cast<const uint8_t*>(data);
+
+			for (size_t i = 0; i < length; i ++) {
+				seed ^= bytes[i];
+				seed *= 0x100000001b3;
+			}
+
+			return seed;
+		}
+
+		inline uint64_t hash(std::string_view value, uint64_t seed = 0xcbf29ce484222325) {
+			return hash(value.data(), value.size(), seed);
+		}
+
+	}
+
 	template <typename C, typename E>
 	inline bool contains(const C& collection, const E& element) {
 		return std::find(std::begin(collection), std::end(collection), element) != std::end(collection);
@@ -2,9 +2,12 @@
 #include "window.hpp"
 #include "time.hpp"
 #include "sound/system.hpp"
+#include "render/state.hpp"
+#include "loader.hpp"
 
 #define UNTITLED_DEFAULT "Untitled"
 static WinxCursor* null_cursor = nullptr;
+static plgl::Canvas* canvas = nullptr;
 
 void plgl::open(const std::string& title, int width, int height) {
 	impl::init();
@@ -25,6 +28,7 @@ void plgl::open(const std::string& title, int width, int height) {
 
 	// use GLAD to load OpenGL functions
 	gladLoadGL();
+	impl::GLState::invalidate();
 
 	// load deafult values into opengl
 	glEnable(GL_MULTISAMPLE);
@@ -32,12 +36,19 @@ void plgl::open(const std::string& title, int width, int height) {
 	glEnable(GL_SCISSOR_TEST);
 	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
+	// with parallel compilation warming up is free, the driver
+	// compiles in the background while we continue with the setup
+	if (Shader::parallel()) {
+		Pipeline::warmup();
+	}
+
 	plgl::opened = true;
 	plgl::should_close = false;
 	plgl::width = width;
 	plgl::height = height;
 	plgl::renderer = new Renderer();
 	plgl::sound_system = new SoundSystem();
+	plgl::loader = new Loader();
 	plgl::focused = winxGetFocus();
 
 	// setup WINX event handlers
@@ -70,13 +81,28 @@ void plgl::listen(Event event, EventHandler callback) {
 }
 
 void plgl::close() {
+	delete plgl::loader;
+	plgl::loader = nullptr;
+
+	if (canvas) {
+		canvas->close();
+		delete canvas;
+		canvas = nullptr;
+	}
+
+	impl::TextureAtlas::close();
+	Font::share(false);
+
+	// the renderer frees GL objects, so it goes before the context, and it's unset first
+	// so that effects destroyed along with it don't try to release themselves from it
+	Renderer* renderer = plgl::renderer;
+	plgl::renderer = nullptr;
+	delete renderer;
+
 	winxClose();
 	plgl::opened = false;
 	plgl::should_close = false;
 
-	delete plgl::renderer;
-	plgl::renderer = nullptr;
-
 	delete plgl::sound_system;
 	plgl::sound_system = nullptr;
 }
@@ -96,17 +122,19 @@ void plgl::background(const Color& color) {
 
 void plgl::swap() {
 	impl::trigger(WINDOW_DRAW);
-	renderer->flush();
+	renderer->endFrame();
 	winxSwapBuffers();
 	winxPollEvents();
 	sound_system->update();
+	loader->update();
+	renderer->beginFrame();
 	glClear(GL_COLOR_BUFFER_BIT);
 	frame_count ++;
 }
 
 void plgl::window_pause() {
 	impl::trigger(WINDOW_DRAW);
-	renderer->flush();
+	renderer->endFrame();
 	winxSwapBuffers();
 
 	while (!should_close) {
@@ -116,6 +144,55 @@ void plgl::window_pause() {
 	}
 }
 
+void plgl::shader_cache(const std::string& path) {
+	Shader::cache(path);
+}
+
+void plgl::font_cache(const std::string& path) {
+	Font::cache(path);
+}
+
+void plgl::font_atlas(bool shared) {
+	Font::share(shared);
+}
+
+void plgl::texture_atlas(int size) {
+	impl::TextureAtlas::enable(size);
+}
+
+void plgl::texture_cache(const std::string& path, bool mipmaps) {
+	impl::TextureCache::enable(path, mipmaps);
+}
+
+plgl::Canvas& plgl::load_pixels() {
+	if (canvas && (canvas->width() != width || canvas->height() != height)) {
+		canvas->close();
+		delete canvas;
+		canvas = nullptr;
+	}
+
+	if (canvas == nullptr) {
+		canvas = new Canvas(width, height);
+	}
+
+	return *canvas;
+}
+
+void plgl::update_pixels() {
+	if (canvas) {
+		renderer->texture(*canvas);
+		renderer->image(0, height, width, height);
+	}
+}
+
+void plgl::warmup() {
+	Pipeline::warmup();
+}
+
+size_t plgl::skipped_binds() {
+	return impl::GLState::skipped();
+}
+
 void plgl::cursor_capture(bool capture) {
 	winxSetCursorCapture(capture);
 }
@@ -4,6 +4,7 @@
 #include "internal.hpp"
 #include "color.hpp"
 #include "render/renderer.hpp"
+#include "render/canvas.hpp"
 
 namespace plgl {
 
@@ -234,6 +235,143 @@ namespace plgl {
 	 */
 	void window_pause();
 
+	/**
+	 * @brief Enable shader binary cache.
+	 *
+	 * Linked shader programs will be stored in the given directory
+	 * and loaded from there on the next run, skipping the (often slow) GLSL compilation.
+	 * Cached programs are invalidated automatically when the shader source
+	 * or the graphics driver changes.
+	 *
+	 * @note Must be called before plgl::open() to also cover the built-in
+	 *       shaders that are compiled when the window opens.
+	 *
+	 * @example
+	 * @code{.cpp}
+	 * int main() {
+	 *
+	 *    // store programs next to the executable
+	 *    shader_cache(".plgl");
+	 *    open("My PLGL Application", 400, 300);
+	 *
+	 *    // ...
+	 *
+	 * }
+	 * @endcode
+	 *
+	 * @param[in] path Path to the cache directory, or an empty string to disable the cache
+	 */
+	void shader_cache(const std::string& path);
+
+	/**
+	 * @brief Enable glyph cache.
+	 *
+	 * Glyphs generated for each font are stored in the given directory when the font is
+	 * destroyed, and loaded back when the same font file is opened with the same weight, so
+	 * text drawn in previous runs doesn't need to be generated again.
+	 *
+	 * @note Only affects fonts opened after this call.
+	 *
+	 * @param[in] path Path to the cache directory, or an empty string to disable the cache
+	 */
+	void font_cache(const std::string& path);
+
+	/**
+	 * @brief Enable shared font atlas.
+	 *
+	 * Fonts opened while this is enabled place their glyphs into one common atlas, so text
+	 * that mixes those fonts (for example regular, bold and monospace) is drawn in one batch,
+	 * instead of flushing every time the font changes.
+	 *
+	 * @note Only affects fonts opened after this call.
+	 *
+	 * @param[in] shared True to share the atlas between new fonts
+	 */
+	void font_atlas(bool shared);
+
+	/**
+	 * @brief Enable automatic texture atlasing.
+	 *
+	 * Textures loaded from files that are no bigger than the given size (in both dimensions)
+	 * are placed into one shared atlas instead of getting their own OpenGL texture. Drawing them
+	 * doesn't require switching textures, so many different small images can be drawn in one batch.
+	 * Atlased textures are used just like any other texture, no code needs to change.
+	 *
+	 * @note Only textures loaded with a Sampler::CLAMP, linear, non-mipmapped sampler are atlased,
+	 *       a sprite in the atlas can't repeat, so textures using the default REPEAT wrap always get their own texture.
+	 *
+	 * @note Only affects textures loaded after this call, space used
+	 *       in the atlas is not reclaimed when a texture is closed.
+	 *
+	 * @param[in] size Maximum width and height of atlased textures, 0 disables atlasing
+	 */
+	void texture_atlas(int size = 256);
+
+	/**
+	 * @brief Enable texture cache.
+	 *
+	 * Images loaded as textures are decoded once and stored in the given directory in a
+	 * pre-decoded format, later loads memory map that file and upload straight from it, skipping
+	 * the decoding altogether. Cached files are refreshed automatically when the source image changes.
+	 * Files with the '.plt' extension (see TextureFile::write()) are always loaded this way, cache or not.
+	 *
+	 * @param[in] path    Path to the cache directory, or an empty string to disable the cache
+	 * @param[in] mipmaps Also store the precomputed mip levels of each texture
+	 */
+	void texture_cache(const std::string& path, bool mipmaps = false);
+
+	/**
+	 * @brief Get window sized pixel canvas.
+	 *
+	 * Returns a canvas with one pixel per window pixel, its contents are kept between frames, so
+	 * only the pixels that change need to be written, only the modified rows are uploaded. Row 0 is
+	 * the bottom of the window. If the window was resized since the last call a new, transparent, canvas is created.
+	 *
+	 * @example
+	 * @code{.cpp}
+	 * Canvas& canvas = load_pixels();
+	 *
+	 * for (int x = 0; x < width; x ++) {
+	 *    canvas.pixel(x, frame_count % height).set(255, 0, 0, 255);
+	 * }
+	 *
+	 * update_pixels();
+	 * @endcode
+	 *
+	 * @see plgl::update_pixels()
+	 */
+	Canvas& load_pixels();
+
+	/**
+	 * @brief Draw the pixel canvas.
+	 *
+	 * Uploads the rows modified since the last upload and draws the canvas returned
+	 * by load_pixels() over the whole window, the canvas is left selected as the current texture.
+	 */
+	void update_pixels();
+
+	/**
+	 * @brief Prepare all built-in shaders.
+	 *
+	 * By default built-in shaders are compiled lazily, the first time
+	 * they are needed, which can cause a visible hitch (for example on the first text draw).
+	 * Calling this after plgl::open() compiles them all up-front. If the driver supports
+	 * KHR_parallel_shader_compile this is done automatically, in the background, when the window opens.
+	 *
+	 * @see plgl::shader_cache()
+	 */
+	void warmup();
+
+	/**
+	 * @brief Number of redundant OpenGL state changes skipped.
+	 *
+	 * Every texture, shader, buffer and framebuffer bind done by the
+	 * renderer is tracked, and binds of objects that are already bound are not passed to the driver.
+	 * This returns the total number of such skipped calls since the program started,
+	 * which can be useful when profiling.
+	 */
+	size_t skipped_binds();
+
 	/**
 	 * @brief Forces the mouse cursor to stay within the bounds of the window.
 	 *
@@ -0,0 +1,60 @@
+#include "context.hpp"
+
+using namespace plgl;
+
+// checks that every texel of the atlas texture matches its page,
+// including the parts of each layer that no sprite was ever placed in
+static bool verify(Atlas& atlas, const char* stage) {
+	atlas.use();
+
+	GLint depth = 0;
+	glGetTexLevelParameteriv(GL_TEXTURE_2D_ARRAY, 0, GL_TEXTURE_DEPTH, &depth);
+
+	const int size = atlas.width();
+	std::vector<uint8_t> texels ((size_t) size * size * 4 * depth);
+
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glGetTexImage(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA, GL_UNSIGNED_BYTE, texels.data());
+
+	for (int layer = 0; layer < atlas.layers(); layer ++) {
+		const uint8_t* expected = (const uint8_t*) atlas.getImage(layer).data();
+		const uint8_t* actual = texels.data() + (size_t) layer * size * size * 4;
+
+		if (memcmp(expected, actual, (size_t) size * size * 4) != 0) {
+			printf("%s: layer %d of %d differs from its page\n", stage, layer, atlas.layers());
+			return false;
+		}
+	}
+
+	printf("%s: %d layers match\n", stage, atlas.layers());
+	return true;
+}
+
+int main() {
+
+	open("Atlas Upload", 100, 100);
+
+	Image tile = Image::allocate(40, 40);
+	tile.clear({255, 0, 0, 255});
+
+	Atlas atlas {64};
+	bool passed = true;
+
+	// fresh atlas, one sprite on the first layer
+	atlas.submit(tile);
+	passed &= verify(atlas, "fresh");
+
+	// every new tile needs a new layer, so the texture grows a few times
+	for (int i = 0; i < 4; i ++) {
+		atlas.submit(tile);
+	}
+
+	passed &= verify(atlas, "grown");
+
+	tile.close();
+	atlas.close();
+	close();
+
+	return passed ? 0 : 1;
+
+}
@@ -0,0 +1,63 @@
+#include "context.hpp"
+
+using namespace plgl;
+
+static const char* vertex_source = R"(
+	#version 330 core
+	layout (location = 0) in vec2 iPos;
+	void main() {
+		gl_Position = vec4(iPos, 0.0, 1.0);
+	}
+)";
+
+static const char* fragment_source = R"(
+	#version 330 core
+	out vec4 fColor;
+	void main() {
+		fColor = vec4(1.0, 0.5, 0.0, 1.0);
+	}
+)";
+
+// builds a shader with the program binary cache enabled, returns the number of cached binaries
+static int build(const std::filesystem::path& directory) {
+	shader_cache(directory.string());
+	open("Shader Cache", 100, 100);
+
+	{
+		Shader shader {vertex_source, fragment_source};
+		shader.use();
+	}
+
+	const GLenum error = glGetError();
+	close();
+
+	if (error != GL_NO_ERROR) {
+		printf("OpenGL error 0x%x\n", error);
+		return -1;
+	}
+
+	int count = 0;
+
+	for (const auto& entry : std::filesystem::directory_iterator {directory}) {
+		if (entry.path().extension() == ".bin") count ++;
+	}
+
+	return count;
+}
+
+int main() {
+
+	const auto directory = std::filesystem::temp_directory_path() / "plgl-shader-cache-test";
+	std::filesystem::remove_all(directory);
+	std::filesystem::create_directories(directory);
+
+	// first run compiles and stores the programs, the second one loads them back
+	const int stored = build(directory);
+	const int loaded = build(directory);
+
+	std::filesystem::remove_all(directory);
+	printf("stored %d, loaded %d binaries\n", stored, loaded);
+
+	return (stored >= 0 && loaded == stored) ? 0 : 1;
+
+}